@@ -0,0 +1,29 @@
+#ifndef __ARC_LENGTH_HPP__
+#define __ARC_LENGTH_HPP__
+
+#include <vector>
+#include <cmath>
+
+#include "utils.hpp"
+
+using namespace std;
+
+// cumulative length lookup over a sampled curve
+class ArcLengthTable {
+    public:
+        void build(const vector<Vec>&);
+
+        double getLength() { return cumulative.empty() ? 0 : cumulative.back(); }
+        double lengthAt(size_t index) { return cumulative[index]; }
+        size_t size() { return points.size(); }
+
+        size_t segmentAt(double);
+        Vec at(double);
+        vector<Vec> resample(double spacing);
+
+    private:
+        vector<Vec> points;
+        vector<double> cumulative;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef __BEZIER_HPP__
+#define __BEZIER_HPP__
+
+#include <vector>
+#include <list>
+#include <cmath>
+
+#include "utils.hpp"
+
+using namespace std;
+
+// Bernstein basis of one (degree, numPoints) pair, row i holds B_k(i / numPoints)
+struct BernsteinTable {
+    int degree;
+    int numPoints;
+    size_t stride;
+    vector<double> basis;
+
+    BernsteinTable(int degree, int numPoints);
+};
+
+// evaluates Bezier curves as basis matrix times control points
+class BezierEvaluator {
+    public:
+        void evaluate(const vector<Vec>& control, int numPoints, vector<Vec>& result);
+
+        static const char* getKernelName();
+
+    private:
+        list<BernsteinTable> cache;
+        vector<double> control_x, control_y;
+
+        BernsteinTable& getTable(int degree, int numPoints);
+        void loadControl(const vector<Vec>&, size_t stride, vector<double>& x, vector<double>& y);
+};
+
+// appends the curve split at t = 0.5 until every piece's control polygon is within tolerance
+// of its chord, the start point is skipped when result already ends there
+void subdivideBezier(const vector<Vec>& control, double tolerance, vector<Vec>& result);
+
+#endif
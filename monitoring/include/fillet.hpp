@@ -0,0 +1,53 @@
+#ifndef __FILLET_HPP__
+#define __FILLET_HPP__
+
+#include <vector>
+#include <cmath>
+
+#include "utils.hpp"
+#include "occupancy.hpp"
+
+using namespace std;
+
+// smooth_type value selecting string pulling with circular fillets
+const int FILLET_PATH = 4;
+
+// straight segment, or circular arc when radius > 0
+struct PathPiece {
+    Vec start, end;
+    Vec center;
+    double radius = 0;
+    double start_angle = 0, sweep = 0;
+    double length = 0;
+
+    Vec at(double s);
+};
+
+// lines between the pulled vertices joined by tangent arcs
+class FilletPath {
+    public:
+        void build(const OccupancyGrid&, const vector<Vec>& vertices, double turn_radius);
+
+        Vec at(double s);
+        vector<Vec> sample(double spacing);
+        vector<Vec> sampleAdaptive(double tolerance);
+
+        double getLength() { return offsets.empty() ? 0 : offsets.back() + pieces.back().length; }
+        size_t getPieceCount() { return pieces.size(); }
+        int getShrunk() { return shrunk; }
+
+    private:
+        vector<PathPiece> pieces;
+        vector<double> offsets;
+        int shrunk = 0;
+
+        void addLine(Vec, Vec);
+        bool arcClear(const OccupancyGrid&, PathPiece&);
+};
+
+// the squares of both end points are not checked so off-grid start and goal points never
+// block themselves
+bool lineOfSight(const OccupancyGrid&, Vec from, Vec to);
+vector<Vec> pullString(const OccupancyGrid&, const vector<Vec>& path);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef __MESSAGE_HPP__
+#define __MESSAGE_HPP__
+
+#include <vector>
+#include <string>
+
+#include "utils.hpp"
+#include "protocol.hpp"
+
+using namespace std;
+
+enum MessageType {
+    MESSAGE_UNKNOWN = 0,
+    MESSAGE_HELLO,
+    MESSAGE_RUN,
+    MESSAGE_TARGET,
+    MESSAGE_NEIGHBORS,
+    MESSAGE_OBSTACLES,
+    MESSAGE_OBSTACLES_ACK,
+    MESSAGE_POSITION,
+    MESSAGE_ASTAR_PATH,
+    MESSAGE_BEZIER_PATH,
+    MESSAGE_PLAN_STATS,
+    MESSAGE_FINISHED
+};
+
+// one JSON text message read straight into its fields, what a type does not carry stays default
+struct Message {
+    int type = MESSAGE_UNKNOWN;
+
+    // hello, binary is set when formats lists it or the reply's format is it
+    int protocol = 0;
+    bool binary = false;
+
+    // run, value is "start" or "stop"
+    bool start = false;
+
+    // run start and the enemies' finished carry a top level target, target carries it as value
+    bool has_target = false;
+    Vec target;
+
+    // position, value.target is the robot's current target
+    PoseFrame pose;
+
+    // neighbors and the paths
+    vector<Vec> points;
+    // obstacles, the enemies changed since base, and its acknowledgement
+    unsigned int sequence = 0, base = 0;
+    double radius = 0;
+    vector<EnemyShape> shapes;
+
+    // plan_stats, and the robot's finished value
+    bool has_value = false;
+    unsigned int id = 0;
+    bool local = false;
+    double plan_us = 0, latency_us = 0;
+    // the ReplanReason name
+    string reason;
+    double time = 0, planned = 0;
+
+    // points keeps its capacity, shapes are dropped with their centers and allocated again
+    void clear();
+};
+
+// SAX parse without building a DOM, false on malformed JSON
+bool decodeMessage(const char* data, size_t size, Message&);
+inline bool decodeMessage(const string& data, Message& message) { return decodeMessage(data.data(), data.size(), message); }
+
+// FrameType a message would have been sent as in binary, -1 for the others
+int messageFrame(int type);
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef __OBSTACLE_MAP_HPP__
+#define __OBSTACLE_MAP_HPP__
+
+#include <vector>
+#include <map>
+
+#include "utils.hpp"
+#include "occupancy.hpp"
+
+using namespace std;
+
+// an enemy as the discs it sweeps, centers[0] is where it is now, the rest is its predicted motion
+struct EnemyShape {
+    int id = 0;
+    vector<Vec> centers;
+};
+
+// shapes closer than this are not sent again
+const double SHAPE_TOLERANCE = 0.5;
+// a robot that stops acknowledging gets a full update once this many are in flight
+const size_t MAX_IN_FLIGHT = 8;
+
+struct ObstacleParameters {
+    double radius = 40;
+    double node_distance = 30;
+    double width = 900, height = 600;
+};
+
+ObstacleParameters makeObstacleParameters(GlobalData*);
+
+// the shapes of the enemies, swept along their tracks in GlobalData::tracker for prediction_horizon seconds
+vector<EnemyShape> trackedShapes(GlobalData*, const vector<Vec>& enemies, double now);
+// nodes within radius of any center, visible ones within half the radius of centers[0] only
+void rasterizeShape(const EnemyShape&, const ObstacleParameters&, vector<Vec>& obstacle, vector<Vec>& visible);
+void rasterizeShapes(const vector<EnemyShape>&, const ObstacleParameters&,
+                     vector<vector<Vec>>& obstacles, vector<vector<Vec>>& visible);
+
+// true when a center moved more than tolerance or the sweep got longer or shorter
+bool shapeChanged(const EnemyShape&, const EnemyShape&, double tolerance);
+
+// the robot's side, keeps every enemy's cells and how many enemies cover each cell,
+// so an update only rasterizes the enemies it names
+class ObstacleMap {
+    public:
+        ObstacleMap(const ObstacleParameters&);
+
+        void reset();
+        // replaces the named enemies, the others keep their cells unless replace is set, a
+        // different radius re-rasterizes every enemy
+        void apply(const vector<EnemyShape>&, double radius, bool replace=false);
+
+        const OccupancyGrid& getGrid() const { return grid; }
+        const vector<vector<Vec>>& getObstacles() const { return obstacles; }
+        // cells whose blocked state flipped in the last apply
+        const vector<size_t>& getChanged() const { return changed; }
+        size_t getRasterized() const { return rasterized; }
+        double getRadius() const { return params.radius; }
+
+    private:
+        ObstacleParameters params;
+        OccupancyGrid grid;
+        vector<EnemyShape> shapes;
+        vector<vector<Vec>> obstacles;
+        vector<vector<size_t>> enemy_cells;
+        vector<uint16_t> coverage;
+        vector<size_t> changed;
+        vector<size_t> touched;
+        size_t rasterized = 0;
+
+        void remove(int id);
+        void cover(size_t cell, int delta);
+};
+
+// the monitor's side, an update carries the enemies that differ from the version the robot
+// acknowledged, plus the ones of updates still in flight, so it applies on top of any of them
+class ObstacleSync {
+    public:
+        // false when the robot is up to date, base 0 means the update replaces everything
+        bool delta(const vector<EnemyShape>&, double radius, vector<EnemyShape>& changed,
+                   unsigned int& sequence, unsigned int& base);
+        void acknowledge(unsigned int sequence);
+        void reset();
+
+        unsigned int getAcknowledged() { return acknowledged; }
+        size_t getInFlight() { return sent.size(); }
+
+    private:
+        struct Sent {
+            vector<EnemyShape> shapes;
+            vector<int> ids;
+            double radius;
+        };
+        unsigned int last_sequence = 0, acknowledged = 0;
+        vector<EnemyShape> acknowledged_shapes;
+        double acknowledged_radius = 0;
+        map<unsigned int, Sent> sent;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef __OCCUPANCY_HPP__
+#define __OCCUPANCY_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+#include "utils.hpp"
+
+using namespace std;
+
+// node grid of the field, cell (i, j) lies at (i, j) * node_distance
+class OccupancyGrid {
+    public:
+        OccupancyGrid(double node_distance=30, double width=900, double height=600);
+
+        void resize(double node_distance, double width, double height);
+        void clear();
+        void build(const vector<vector<Vec>>& obstacles);
+        void set(int i, int j, bool value);
+
+        bool inside(int i, int j) const { return i >= 0 && j >= 0 && i < cols && j < rows; }
+        bool blocked(int i, int j) const { return !inside(i, j) || cells[index(i, j)]; }
+        bool blocked(Vec) const;
+        // walks the squares of side node_distance owned by the nodes along a segment
+        bool segmentClear(Vec from, Vec to, bool check_from=true, bool check_to=true) const;
+
+        size_t index(int i, int j) const { return static_cast<size_t>(j) * cols + i; }
+        void toCell(Vec, int&, int&) const;
+        Vec toPoint(int i, int j) const { return Vec(i * node_distance, j * node_distance); }
+
+        int getCols() const { return cols; }
+        int getRows() const { return rows; }
+        size_t getSize() const { return cells.size(); }
+        double getNodeDistance() const { return node_distance; }
+        unsigned int getVersion() const { return version; }
+
+    private:
+        double node_distance, width, height;
+        int cols = 0, rows = 0;
+        unsigned int version = 0;
+        vector<uint8_t> cells;
+};
+
+#endif
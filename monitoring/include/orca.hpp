@@ -0,0 +1,68 @@
+#ifndef __ORCA_HPP__
+#define __ORCA_HPP__
+
+#include <vector>
+#include <unordered_map>
+#include <cmath>
+
+#include "utils.hpp"
+
+using namespace std;
+
+// neighbor agent seen by the local avoidance layer
+struct Agent {
+    Vec position;
+    Vec velocity;
+    double radius;
+};
+
+// half plane of permitted velocities, left side of direction
+struct OrcaLine {
+    Vec point;
+    Vec direction;
+};
+
+// uniform grid hash over agent positions
+class SpatialHash {
+    public:
+        void build(const vector<Agent>&, double cell_size);
+        void query(Vec, double range, vector<size_t>& result);
+
+    private:
+        double cell_size = 1;
+        unordered_map<long long, vector<size_t>> cells;
+        vector<Vec> positions;
+
+        long long key(int, int);
+};
+
+// reciprocal velocity obstacle (ORCA) solver
+class LocalAvoidance {
+    public:
+        LocalAvoidance(double radius, double max_speed, double time_horizon, double neighbor_distance);
+
+        // time must run on the clock of computeVelocity's time_step, the velocities are differences over it
+        void updateNeighbors(const vector<Vec>&, double time);
+        Vec computeVelocity(Vec position, Vec velocity, Vec preferred, double time_step);
+
+        size_t getNeighborCount() { return agents.size(); }
+        double getComputeTime() { return compute_time; }
+        double getMaxSpeed() { return max_speed; }
+
+    private:
+        double radius, max_speed, time_horizon, neighbor_distance;
+        double last_update = -1;
+        double compute_time = 0;
+        bool velocity_ready = false;
+
+        vector<Agent> agents;
+        vector<size_t> neighbors;
+        vector<OrcaLine> orca_lines, projected;
+        SpatialHash hash;
+
+        bool linearProgram1(const vector<OrcaLine>&, size_t, double, Vec, bool, Vec&);
+        size_t linearProgram2(const vector<OrcaLine>&, double, Vec, bool, Vec&);
+        void linearProgram3(const vector<OrcaLine>&, size_t, double, Vec&);
+};
+
+#endif
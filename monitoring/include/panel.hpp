@@ -20,6 +20,9 @@
 #include <nlohmann/json.hpp>
 
 #include "render_area.hpp"
+#include "protocol.hpp"
+#include "message.hpp"
+#include "obstacle_map.hpp"
 
 using nlohmann::json;
 
@@ -52,6 +55,10 @@ class Panel : public QWidget {
     QLabel *bezierSpinLabel;
     QLabel *bezierSliderLabel;
     QWebSocket *robotSocket[6];
+    ProtocolStats decode_stats;
+    Message message;
+    // what the robot's obstacle map already has
+    ObstacleSync obstacle_sync;
 
     void handleLeftButton();
     void handleRightButton();
@@ -59,7 +66,10 @@ class Panel : public QWidget {
     void handleStartButton();
     
     void handleTimer();
-    void handleSocketMessage(int, string);
+    void handleSocketMessage(int, const char*, size_t);
+    void handleSocketFrame(int, const string&);
+    void applyPose(int, const PoseFrame&);
+    void sendHello(int);
 };
 
 #endif
\ No newline at end of file
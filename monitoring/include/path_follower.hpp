@@ -0,0 +1,46 @@
+#ifndef __PATH_FOLLOWER_HPP__
+#define __PATH_FOLLOWER_HPP__
+
+#include <vector>
+#include <cmath>
+
+#include "utils.hpp"
+#include "arc_length.hpp"
+
+using namespace std;
+
+// pure pursuit along a sampled path, progress only moves forward
+class PathFollower {
+    public:
+        PathFollower(double bucket_size=60): bucket_size(bucket_size) {}
+
+        void setPath(const vector<Vec>&);
+        void update(Vec position);
+        Vec getLookahead(double distance);
+
+        size_t getIndex() { return index; }
+        double getProgress() { return progress; }
+        double getRemaining() { return arcs.getLength() - progress; }
+        // signed distance to the path, the sign tells the side of the path
+        double getCrossTrack() { return cross_track; }
+        size_t getSearched() { return searched; }
+        bool empty() { return points.size() < 2; }
+
+    private:
+        double bucket_size;
+        vector<Vec> points;
+        ArcLengthTable arcs;
+        size_t index = 0;
+        double progress = 0, cross_track = 0;
+        size_t searched = 0;
+
+        // segments by the buckets their bounding box overlaps, for the lost robot fallback
+        Vec origin;
+        int bucket_cols = 0, bucket_rows = 0;
+        vector<vector<size_t>> buckets;
+
+        double distanceTo(size_t segment, Vec, double& t);
+        bool searchBuckets(Vec, size_t& best);
+};
+
+#endif
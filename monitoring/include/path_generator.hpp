@@ -3,52 +3,83 @@
 
 #include <vector>
 #include <algorithm>
+#include <memory>
 #include <cmath>
 #include <nlohmann/json.hpp>
 
 #include "utils.hpp"
+#include "occupancy.hpp"
+#include "reach_field.hpp"
+#include "bezier.hpp"
+#include "arc_length.hpp"
+#include "planner.hpp"
 
 using namespace std;
 using nlohmann::json;
 
-struct Node {
-    double G, H;
+// a node the step mode opened, for drawing
+struct SearchNode {
     Vec coordinate;
-    Node *parent;
-
-    Node(Vec, Node* parent_=nullptr);
-    double getScore();
+    double G, H;
+    bool closed;
+    bool has_parent;
+    Vec parent;
 };
 
 class PathGenerator {
     public:
+        enum ReplanResult { REPLAN_NONE, REPLAN_LOCAL, REPLAN_FULL };
+
         PathGenerator(GlobalData* global_): global(global_) {}
         ~PathGenerator(){}
 
         void generatePath();
+        void generatePath(const vector<Goal>&, bool to_ball=false);
+        void generateApproachPath();
         void generateSmoothPath(int);
+        ReplanResult replanLocal(int&);
+        vector<Goal> getApproachGoals();
+        // the GUI's step mode, the same search as a full plan one expanded node per stepSearch
+        void setSearch(Vec, const vector<Goal>&);
+        bool stepSearch();
+        void clearSearch();
+        vector<SearchNode> getSearchNodes();
+        // a grid kept up to date elsewhere, used instead of building one from global->obstacles
+        void setObstacleGrid(shared_ptr<const OccupancyGrid> grid) { shared_grid = grid; }
 
         double getAstarLength();
         double getBezierLength();
         int getTotalVisitedNode();
+        int getGoalIndex() { return goal_index; }
 
-        bool astar_find_next_node();
-        void astar_find_neighbors(bool ignore_head=false);
-        void process_path();
         void modified_path(bool ignore_head=false);
         void getBezierPoints(int, int);
 
-        vector<Node*> openList, closeList;
-        Node* current;
-
     private:
         GlobalData* global;
+        OccupancyGrid reach_grid;
+        ReachField reach;
+        bool use_reach = false;
+
+        int goal_index = -1;
+        // the step mode's search keeps its own scratch, full plans on this thread reuse theirs
+        PlanQuery step_query;
+        SearchScratch step_scratch;
+        unique_ptr<GridSearch> step_search;
+        PlanStats step_stats;
+
+        BezierEvaluator evaluator;
+        ArcLengthTable bezier_table;
+        unsigned long bezier_table_version = 0;
+        shared_ptr<const OccupancyGrid> obstacle_grid, shared_grid;
+        int planned_nodes = 0;
+        vector<Vec> slider_control, slider_curve;
+        int slider_samples = 0;
 
-        double heuristic(Vec, Vec, int);
-        bool detectCollision(Vec);
-        vector<Vec> getNeighbors(Vec, bool ignore_head=false);
-        Node* findNodeOnList(vector<Node*>&, Vec);
-        void releaseNodes(vector<Node*>&);
+        PlanQuery makeQuery(Vec, const vector<Goal>&);
+        vector<Vec> smoothCurve(const vector<Vec>&, int);
+        void updateReachField();
+        void updateObstacleGrid();
 };
 
 #endif
@@ -0,0 +1,32 @@
+#ifndef __PATH_VALIDATOR_HPP__
+#define __PATH_VALIDATOR_HPP__
+
+#include <vector>
+#include <cmath>
+
+#include "utils.hpp"
+#include "occupancy.hpp"
+
+using namespace std;
+
+// batched clearance test of a sampled path against enemy circles and the occupancy grid
+class PathValidator {
+    public:
+        // called once per adopted path, the segment arrays are rebuilt on every call
+        void setPath(const vector<Vec>&);
+        void setEnemies(const vector<Vec>&, double radius);
+
+        // index of the first sample whose segment to the next sample is invalid, -1 if clear
+        int firstInvalid(size_t from, const OccupancyGrid* grid=nullptr);
+
+        static const char* getKernelName();
+
+    private:
+        vector<Vec> points;
+        // segment k runs from (start_x, start_y) along (delta_x, delta_y), padded to the SIMD width
+        vector<double> start_x, start_y, delta_x, delta_y, inv_len_sq;
+        vector<double> enemy_x, enemy_y;
+        double radius_sq = 0;
+};
+
+#endif
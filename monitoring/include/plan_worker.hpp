@@ -0,0 +1,85 @@
+#ifndef __PLAN_WORKER_HPP__
+#define __PLAN_WORKER_HPP__
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+#include "utils.hpp"
+#include "path_generator.hpp"
+#include "world_model.hpp"
+#include "protocol.hpp"
+
+using namespace std;
+
+// published plan, never modified once the worker hands it out
+struct PlanSnapshot {
+    unsigned int id = 0;
+    int generation = 0;
+    unsigned long world_version = 0;
+    bool local = false;
+    // ReplanReason of the request, -1 for a start
+    int reason = -1;
+    vector<Vec> astar_path, normal_astar_path, bezier_path;
+    // both encodings are made on the worker, the sending thread picks the negotiated one
+    string astar_message, bezier_message;
+    string astar_frame, bezier_frame;
+    double astar_json_us = 0, bezier_json_us = 0, astar_frame_us = 0, bezier_frame_us = 0;
+    double astar_length = 0;
+    chrono::steady_clock::time_point submitted, published;
+    double queue_us = 0, plan_us = 0;
+};
+
+// a plan of one world version
+struct PlanRequest {
+    int generation = 0;
+    // repair base around path_index before falling back to a full plan
+    bool local = false;
+    int path_index = 0;
+    shared_ptr<const PlanSnapshot> base;
+    int reason = -1;
+
+    shared_ptr<const WorldSnapshot> world;
+};
+
+// plans on its own thread, a newer request replaces the one still waiting
+class PlanWorker {
+    public:
+        PlanWorker(const GlobalData&);
+        ~PlanWorker();
+
+        unsigned int submit(PlanRequest);
+        shared_ptr<const PlanSnapshot> latest() const { return atomic_load(&published); }
+
+        bool isBusy() { return busy; }
+        size_t getDropped() { return dropped; }
+        size_t getCompleted() { return completed; }
+
+    private:
+        GlobalData global;
+        PathGenerator generator;
+
+        thread worker;
+        mutex queue_mutex;
+        condition_variable queue_cv;
+        bool has_pending = false, stopping = false;
+        PlanRequest pending;
+        unsigned int pending_id = 0, next_id = 0;
+        chrono::steady_clock::time_point pending_time;
+
+        // front buffer, swapped atomically once the back one is complete
+        shared_ptr<const PlanSnapshot> published;
+        atomic<bool> busy{false};
+        atomic<size_t> dropped{0}, completed{0};
+
+        void loop();
+        void plan(const PlanRequest&, PlanSnapshot&);
+        void encode(PlanSnapshot&);
+};
+
+#endif
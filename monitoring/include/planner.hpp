@@ -0,0 +1,173 @@
+#ifndef __PLANNER_HPP__
+#define __PLANNER_HPP__
+
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+
+#include "utils.hpp"
+#include "occupancy.hpp"
+#include "bezier.hpp"
+
+using namespace std;
+
+// search goal with a terminal cost added when the path ends there
+struct Goal {
+    Vec point;
+    double cost;
+};
+
+// the GlobalData values a plan depends on, copied so a query never reads shared state
+struct PlanParameters {
+    double node_distance = 30;
+    double screen_width = 900, screen_height = 600;
+    int heuristic_type = 1;
+    int smooth_type = 0;
+    int bezier_curvature = 5;
+    double path_spacing = 10;
+    double flatness_tolerance = 0;
+    double min_turn_radius = 60;
+    double reach_weight = 0;
+    double max_speed = 20;
+};
+
+PlanParameters makePlanParameters(GlobalData*);
+
+// immutable plan input, the grid and reach times are shared snapshots
+struct PlanQuery {
+    Vec start;
+    vector<Goal> goals;
+    // appended after the goal node like the legacy A* path, the goal itself when not set
+    bool use_end = false;
+    Vec end;
+
+    shared_ptr<const OccupancyGrid> grid;
+    // per cell time the fastest enemy needs, same layout as the grid
+    shared_ptr<const vector<double>> reach_times;
+
+    bool use_window = false;
+    Vec window_min, window_max;
+
+    bool smooth = true;
+    // 0 samples one point per 10 px of the A* path
+    int smooth_points = 0;
+    PlanParameters params;
+};
+
+struct PlanStats {
+    size_t expanded = 0;
+    size_t visited = 0;
+    double search_us = 0;
+    double smooth_us = 0;
+};
+
+struct PlanResult {
+    bool found = false;
+    int goal_index = -1;
+    // searched nodes from the start to the goal node
+    vector<Vec> nodes;
+    // legacy A* path layout, start + nodes + end
+    vector<Vec> path;
+    vector<Vec> smooth_path;
+    vector<Vec> visited;
+    PlanStats stats;
+};
+
+enum NodeState : uint8_t { NODE_NEW = 0, NODE_OPEN = 1, NODE_CLOSED = 2 };
+
+// search memory, sized to the largest query it has seen
+struct SearchScratch {
+    vector<double> G, H, length;
+    vector<int> parent;
+    vector<uint32_t> order;
+    vector<uint8_t> state;
+    vector<Vec> coordinate;
+
+    struct Entry {
+        double score;
+        uint32_t order;
+        int id;
+        double G;
+    };
+    vector<Entry> heap;
+
+    BezierEvaluator evaluator;
+
+    void reset(size_t nodes);
+};
+
+// grid A* over cell indices, then the start and the goals, each its own node when off the grid.
+// Planner::plan runs it to the end, the GUI's step mode expands one node at a time
+class GridSearch {
+    public:
+        // opens the start, the query and the scratch must outlive the search
+        GridSearch(const PlanQuery&, SearchScratch&);
+
+        // expands the next open node, true once the best goal is final or nothing is left open
+        bool step(PlanStats&, vector<Vec>* visited=nullptr);
+        // the reached goal's node, -1 if none
+        int run(PlanStats&, vector<Vec>* visited=nullptr);
+
+        bool isDone() const { return done; }
+        int getBest() const { return best; }
+        int getGoalIndex() const { return goal_index; }
+        // searched nodes from the start to id
+        vector<Vec> nodesTo(int id) const;
+
+        // read only view of the nodes, for drawing the search
+        size_t getNodeCount() const { return s.state.size(); }
+        int getState(int id) const { return s.state[id]; }
+        int getParent(int id) const { return s.parent[id]; }
+        Vec getCoordinate(int id) const { return s.coordinate[id]; }
+        double getG(int id) const { return s.G[id]; }
+        double getH(int id) const { return s.H[id]; }
+
+    private:
+        const PlanQuery &query;
+        const PlanParameters &params;
+        SearchScratch &s;
+        double nd;
+        int cols;
+        size_t cells;
+        int start_id;
+        bool start_on_grid;
+        pair<int, int> start_area;
+        vector<int> goal_ids;
+        vector<pair<pair<int, int>, int>> goal_areas;
+        uint32_t inserted = 0;
+        int best = -1;
+        double best_cost = 0;
+        int goal_index = -1;
+        bool done = false;
+
+        pair<int, int> area(Vec point) const;
+        int cellId(int i, int j) const;
+        static bool inArea(pair<int, int> base, int i, int j);
+        int findGoal(int id) const;
+        double goalHeuristic(Vec pos) const;
+        bool blocked(int id) const;
+        double reachCost(Vec pos, double length) const;
+        void push(int id);
+        int pop();
+        void open(int id, int parent, double G, double length);
+        void relax(int from, int id, PlanStats&, vector<Vec>* visited);
+        void expand(int id, PlanStats&, vector<Vec>* visited);
+};
+
+// reentrant planner, all scratch memory is per thread so queries may run concurrently
+class Planner {
+    public:
+        static PlanResult plan(const PlanQuery&);
+
+        // the curve a plan gets from its start, nodes and end
+        static vector<Vec> smoothPath(const vector<Vec>& path, const PlanParameters&,
+                                      const OccupancyGrid&, int numPoints);
+        // the curve over control exactly as given
+        static vector<Vec> smoothCurve(const vector<Vec>& control, const PlanParameters&,
+                                       const OccupancyGrid&, int numPoints);
+        static vector<Vec> padCorners(const vector<Vec>& path, int curvature, bool ignore_head=false);
+        static double heuristic(Vec, Vec, int type);
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef __PROTOCOL_HPP__
+#define __PROTOCOL_HPP__
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+#include "utils.hpp"
+#include "obstacle_map.hpp"
+
+using namespace std;
+using nlohmann::json;
+
+// binary frames start with FRAME_MAGIC, the version and the frame type
+const uint8_t FRAME_MAGIC = 0xB5;
+const uint8_t PROTOCOL_VERSION = 1;
+const size_t FRAME_HEADER_SIZE = 4;
+// path coordinates are sent in 1 / PATH_RESOLUTION px steps
+const double PATH_RESOLUTION = 100;
+
+enum FrameType {
+    FRAME_POSE = 1,
+    FRAME_ASTAR_PATH = 2,
+    FRAME_BEZIER_PATH = 3,
+    FRAME_TYPE_COUNT
+};
+
+// telemetry of one control step, sent as little endian float32 fields
+struct PoseFrame {
+    double x = 0, y = 0, dir = 0;
+    double target_x = 0, target_y = 0;
+    double cross_track = 0;
+    double avoidance_us = 0, validity_us = 0, snapshot_us = 0;
+    uint32_t step = 0;
+};
+
+const size_t POSE_FRAME_SIZE = FRAME_HEADER_SIZE + 9 * 4 + 4;
+
+string encodePose(const PoseFrame&);
+// count, then the first point and the deltas to each next point as zigzag varints
+string encodePath(FrameType, const vector<Vec>&);
+
+// FrameType of a binary frame of this version, -1 for anything else
+int frameType(const string&);
+// false for a frame of another type, a truncated one or one with trailing bytes
+bool decodePose(const string&, PoseFrame&);
+bool decodePath(const string&, vector<Vec>&);
+
+// the JSON fallback, same messages the controllers always sent
+json poseJson(const PoseFrame&, bool with_target);
+string pathJson(const string& type, const vector<Vec>&);
+// enemy shapes changed since base, the robot answers with obstaclesAckJson once applied
+string obstaclesJson(unsigned int sequence, unsigned int base, double radius, const vector<EnemyShape>&);
+string obstaclesAckJson(unsigned int sequence);
+
+const char* frameName(int type);
+
+class ProtocolStats;
+// a pose in the negotiated format, binary senders also time the JSON encoding every
+// JSON_SAMPLE_INTERVAL poses so the stats can tell what was saved
+const size_t JSON_SAMPLE_INTERVAL = 64;
+string encodePoseMessage(const PoseFrame&, bool binary, bool with_target, ProtocolStats&);
+
+// per frame type message count, bytes and coding time against the JSON encoding
+class ProtocolStats {
+    public:
+        void record(int type, size_t bytes, double us);
+        void recordJson(int type, size_t bytes, double us);
+        string report();
+        size_t getMessages(int type) { return type > 0 && type < FRAME_TYPE_COUNT ? entries[type].messages : 0; }
+
+    private:
+        struct Entry {
+            size_t messages = 0, bytes = 0;
+            double us = 0;
+            size_t json_messages = 0, json_bytes = 0;
+            double json_us = 0;
+        };
+        Entry entries[FRAME_TYPE_COUNT];
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef __REACH_FIELD_HPP__
+#define __REACH_FIELD_HPP__
+
+#include <vector>
+#include <limits>
+
+#include "utils.hpp"
+#include "occupancy.hpp"
+
+using namespace std;
+
+// per enemy time-to-reach fields and the merged dominance map
+class ReachField {
+    public:
+        void update(OccupancyGrid& grid, const vector<Vec>& enemies, double speed);
+        void reset();
+
+        bool empty() { return dominance.empty(); }
+        double enemyTime(size_t cell) { return dominance[cell]; }
+        int dominantEnemy(size_t cell) { return owner[cell]; }
+        double timeOf(size_t enemy, size_t cell) { return fields[enemy][cell]; }
+        const vector<double>& getDominance() { return dominance; }
+        size_t getRecomputed() { return recomputed; }
+
+    private:
+        vector<vector<double>> fields;
+        vector<pair<int, int>> sources;
+        vector<double> dominance;
+        vector<int> owner;
+        unsigned int grid_version = 0;
+        double field_speed = 0;
+        size_t recomputed = 0;
+
+        static void propagate(OccupancyGrid& grid, Vec source, double speed, vector<double>& field);
+};
+
+#endif
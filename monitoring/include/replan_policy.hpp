@@ -0,0 +1,75 @@
+#ifndef __REPLAN_POLICY_HPP__
+#define __REPLAN_POLICY_HPP__
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+#include "utils.hpp"
+#include "occupancy.hpp"
+#include "path_validator.hpp"
+#include "world_model.hpp"
+
+using namespace std;
+
+enum ReplanReason {
+    REPLAN_BLOCKED = 0,
+    REPLAN_CLEARANCE,
+    REPLAN_IMPROVEMENT,
+    REPLAN_REASON_COUNT
+};
+
+// "start" for -1, a plan nobody asked to replace
+const char* replanReasonName(int reason);
+
+// a clearance no worse than the plan's own by this much is what the planner could do
+const double CLEARANCE_TOLERANCE = 5;
+
+struct ReplanDecision {
+    // -1 keeps the path
+    int reason = -1;
+    // repair around the robot's progress before planning from scratch
+    bool local = false;
+};
+
+// decides whether the followed path is worth replacing, the grid is only walked again
+// when an obstacle update blocked cells next to the path
+class ReplanPolicy {
+    public:
+        ReplanPolicy(const GlobalData&);
+
+        // a newly adopted path, the first check walks the whole grid and takes its clearance
+        void setPath(const vector<Vec>&, const OccupancyGrid&);
+        // cells an obstacle update flipped, kept until a check looks at them
+        void invalidate(const vector<size_t>& changed, const OccupancyGrid&);
+        ReplanDecision check(const WorldSnapshot&, size_t path_index, chrono::steady_clock::time_point now);
+
+        size_t getTriggered(int reason) { return triggered[reason]; }
+        size_t getSkipped(int reason) { return skipped[reason]; }
+        size_t getChecks() { return checks; }
+        size_t getGridWalks() { return grid_walks; }
+        string report();
+
+    private:
+        double interval, min_clearance, min_improvement, horizon, enemy_radius;
+        PathValidator validator;
+        vector<Vec> points;
+        // cells next to a path sample, a cell blocked outside them cannot invalidate it
+        vector<uint8_t> corridor;
+        bool grid_dirty = true;
+        // cells freed since the last check, where a shortcut could go
+        vector<Vec> freed;
+        // clearance of the path when it was adopted, -1 until the first check
+        double plan_clearance = -1;
+        chrono::steady_clock::time_point last_replan;
+
+        size_t triggered[REPLAN_REASON_COUNT] = {};
+        size_t skipped[REPLAN_REASON_COUNT] = {};
+        size_t checks = 0, grid_walks = 0;
+
+        ReplanDecision decide(int reason, bool local, chrono::steady_clock::time_point now);
+        double clearance(const vector<Vec>& enemies, size_t from);
+        double remainingLength(size_t from);
+};
+
+#endif
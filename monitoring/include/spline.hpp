@@ -0,0 +1,48 @@
+#ifndef __SPLINE_HPP__
+#define __SPLINE_HPP__
+
+#include <vector>
+#include <cmath>
+
+#include "utils.hpp"
+
+using namespace std;
+
+enum SplineType {
+    UNIFORM_BSPLINE = 1,
+    UNIFORM_CATMULL_ROM = 2,
+    CENTRIPETAL_CATMULL_ROM = 3
+};
+
+// piecewise cubic curve over a control polygon, each segment depends on four points only
+class SplinePath {
+    public:
+        SplinePath(int type=UNIFORM_BSPLINE): type(type) {}
+
+        void setType(int);
+        void setPoints(const vector<Vec>&, int numPoints);
+        // evaluated once per setPoints
+        vector<Vec>& getSamples();
+        vector<Vec> getAdaptiveSamples(double tolerance);
+
+        void getSegmentBezier(size_t, Vec*);
+
+    private:
+        int type;
+        double spacing = 10;
+        bool changed = false;
+
+        vector<Vec> points;
+        vector<Vec> padded;
+        vector<vector<Vec>> segment_samples;
+        vector<Vec> samples;
+
+        size_t padding();
+        void updatePadding();
+        void evaluateSegment(size_t);
+};
+
+vector<Vec> evaluateSpline(const vector<Vec>&, int type, int numPoints);
+vector<Vec> subdivideSpline(const vector<Vec>&, int type, double tolerance);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef __SPSC_RING_HPP__
+#define __SPSC_RING_HPP__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+using namespace std;
+
+// bounded single producer, single consumer queue, neither side ever takes a lock
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "ring capacity must be a power of two");
+
+    public:
+        // producer side, false when the ring is full
+        bool push(T&& item) {
+            size_t write = write_index.load(memory_order_relaxed);
+            if (write - cached_read >= N) {
+                cached_read = read_index.load(memory_order_acquire);
+                if (write - cached_read >= N) return false;
+            }
+            slots[write & (N - 1)] = move(item);
+            write_index.store(write + 1, memory_order_release);
+            return true;
+        }
+
+        // consumer side, false when the ring is empty
+        bool pop(T& item) {
+            size_t read = read_index.load(memory_order_relaxed);
+            if (read == cached_write) {
+                cached_write = write_index.load(memory_order_acquire);
+                if (read == cached_write) return false;
+            }
+            item = move(slots[read & (N - 1)]);
+            read_index.store(read + 1, memory_order_release);
+            return true;
+        }
+
+        size_t size() const {
+            return write_index.load(memory_order_acquire) - read_index.load(memory_order_acquire);
+        }
+        static constexpr size_t capacity() { return N; }
+
+    private:
+        // each side owns one index and a cached copy of the other, on separate cache lines
+        alignas(64) atomic<size_t> read_index{0};
+        size_t cached_write = 0;
+        alignas(64) atomic<size_t> write_index{0};
+        size_t cached_read = 0;
+        alignas(64) array<T, N> slots;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef __TRACKER_HPP__
+#define __TRACKER_HPP__
+
+#include <vector>
+#include <cmath>
+
+#include "utils.hpp"
+
+using namespace std;
+
+// constant velocity Kalman filter with an estimated turn rate
+class KalmanTrack {
+    public:
+        KalmanTrack(Vec position, double time);
+
+        void update(Vec measurement, double time);
+        Vec predict(double time);
+        vector<Vec> predictPath(double time, double horizon, double step);
+
+        Vec getPosition() { return Vec(state[0][0], state[1][0]); }
+        Vec getVelocity() { return Vec(state[0][1], state[1][1]); }
+        double getTurnRate() { return turn_rate; }
+        double getTime() { return last_time; }
+
+    private:
+        // per axis state (position, velocity) and covariance
+        double state[2][2];
+        double covariance[2][2][2];
+        double last_time;
+        double turn_rate = 0;
+        int updates = 0;
+
+        void propagate(double dt);
+};
+
+// one track per enemy, indexed like GlobalData::enemies
+class EnemyTracker {
+    public:
+        ~EnemyTracker();
+
+        void update(size_t id, Vec position, double time);
+        void reset();
+
+        bool hasTrack(size_t id);
+        KalmanTrack* getTrack(size_t id);
+        Vec predict(size_t id, double time);
+        vector<Vec> predictPath(size_t id, double time, double horizon, double step);
+
+        static double now();
+
+    private:
+        vector<KalmanTrack*> tracks;
+};
+
+#endif
@@ -5,26 +5,15 @@
 #include <fstream>
 #include <cmath>
 #include <vector>
+#include <memory>
 
 #include <nlohmann/json.hpp>
 
+#include "vec.hpp"
+
 using namespace std;
 using nlohmann::json;
-// Vec class
-class Vec {
-  public:
-    double x = 0, y = 0;
-    Vec(double x=0, double y=0);  
-    double len();
-    // Vec class operator
-    Vec operator+(Vec);
-    Vec operator-(Vec);
-    Vec operator*(double);
-    Vec operator/(double);
-    bool operator==(Vec);
-};
-// Vec cout overload function
-ostream& operator<<(ostream &os, Vec vec);
+class EnemyTracker;
 // GlobalData class
 class GlobalData {
   public:
@@ -35,6 +24,8 @@ class GlobalData {
     void updatePosition();
     void updateObstacles();
     void updateTargetPosition();
+    // every write to bezier_path goes through here, caches of it compare bezier_version
+    void setBezierPath(const vector<Vec>&);
     void saveValue();
     void saveTargetPosition();
     // public data
@@ -49,11 +40,34 @@ class GlobalData {
     int path_number;
     int heuristic_type;
     int bezier_curvature;
+    double max_speed;
+    double neighbor_distance;
+    double time_horizon;
+    double prediction_horizon;
+    double reach_weight;
+    int approach_goals;
+    double approach_weight;
+    // center of the goal the robot attacks, in screen px
+    Vec opponent_goal;
+    int replan_window;
+    int smooth_type;
+    double path_spacing;
+    double flatness_tolerance;
+    double min_turn_radius;
+    double replan_interval;
+    double replan_clearance;
+    double replan_improvement;
+    double gait_ramp_periods;
+    double turn_per_period;
+    double lookahead_distance;
+    double telemetry_rate;
     // robot data
     Vec robot;
     Vec ball;
     Vec target;
     vector<Vec> enemies;
+    // shared by copies, a copy used on another thread takes its own
+    shared_ptr<EnemyTracker> tracker;
     vector<vector<Vec>> obstacles;
     vector<vector<Vec>> obstacles_visible;
     vector<vector<Vec>> target_position;
@@ -63,6 +77,7 @@ class GlobalData {
     vector<Vec> normal_astar_path;
     vector<Vec> modified_astar_path;
     vector<Vec> bezier_path;
+    unsigned long bezier_version = 0;
     vector<Vec> normal_bezier_path;
     vector<Vec> following_path;
     vector<Vec> actual_path;
@@ -0,0 +1,37 @@
+#ifndef __VEC_HPP__
+#define __VEC_HPP__
+
+#include <cmath>
+#include <ostream>
+
+using namespace std;
+
+// Vec class, defined in the header so every operator inlines
+class Vec {
+  public:
+    double x = 0, y = 0;
+    constexpr Vec(double x=0, double y=0): x(x), y(y) {}
+
+    double len() const { return sqrt(x*x + y*y); }
+    constexpr double lenSq() const { return x*x + y*y; }
+    constexpr double dot(const Vec& vec) const { return x*vec.x + y*vec.y; }
+    constexpr double cross(const Vec& vec) const { return x*vec.y - y*vec.x; }
+
+    // Vec class operator
+    constexpr Vec operator+(const Vec& vec) const { return Vec(x + vec.x, y + vec.y); }
+    constexpr Vec operator-(const Vec& vec) const { return Vec(x - vec.x, y - vec.y); }
+    constexpr Vec operator-() const { return Vec(-x, -y); }
+    constexpr Vec operator*(double scalar) const { return Vec(x * scalar, y * scalar); }
+    constexpr Vec operator/(double scalar) const { return Vec(x / scalar, y / scalar); }
+    constexpr bool operator==(const Vec& vec) const { return x == vec.x && y == vec.y; }
+    constexpr bool operator!=(const Vec& vec) const { return !(*this == vec); }
+    Vec& operator+=(const Vec& vec) { x += vec.x; y += vec.y; return *this; }
+    Vec& operator-=(const Vec& vec) { x -= vec.x; y -= vec.y; return *this; }
+};
+
+// Vec cout overload function
+inline ostream& operator<<(ostream &os, const Vec& vec) {
+    return os << "{" << vec.x << "," << vec.y << "}";
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __VELOCITY_PROFILE_HPP__
+#define __VELOCITY_PROFILE_HPP__
+
+#include <vector>
+#include <string>
+#include <cmath>
+
+#include "utils.hpp"
+
+using namespace std;
+
+// speed in cm/s, acceleration in cm/s^2, turn rate in rad/s
+struct ProfileLimits {
+    double max_speed = 20;
+    double max_accel = 20;
+    double max_turn_rate = 1;
+};
+
+// walking.ini gives the gait period, the per period limits come from the parameters
+ProfileLimits loadGaitLimits(GlobalData*, const string& walking_config);
+
+// time optimal speed along a sampled path under curvature and acceleration limits
+class VelocityProfile {
+    public:
+        void build(const vector<Vec>& path, ProfileLimits, double start_speed=0, double end_speed=0);
+
+        // the follower's progress picks the speed, not the elapsed time
+        double speedAtDistance(double s);
+
+        double getDuration() { return times.empty() ? 0 : times.back(); }
+        double getLength() { return arcs.empty() ? 0 : arcs.back(); }
+
+    private:
+        vector<Vec> points;
+        vector<double> arcs, speeds, times;
+};
+
+#endif
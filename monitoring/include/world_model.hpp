@@ -0,0 +1,61 @@
+#ifndef __WORLD_MODEL_HPP__
+#define __WORLD_MODEL_HPP__
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "utils.hpp"
+#include "occupancy.hpp"
+#include "obstacle_map.hpp"
+
+using namespace std;
+
+// one immutable version of the world, the large members are shared between versions.
+// the plan being followed is the PlanSnapshot the robot adopted, not part of the world
+struct WorldSnapshot {
+    unsigned long version = 0;
+    Vec robot, ball;
+    shared_ptr<const vector<Vec>> enemies;
+    shared_ptr<const vector<vector<Vec>>> obstacles;
+    shared_ptr<const OccupancyGrid> grid;
+    // cells whose blocked state differs from the previous version's grid
+    shared_ptr<const vector<size_t>> changed_cells;
+};
+
+// read-copy-update holder, readers never lock, writers publish a modified copy.
+// the GlobalData it starts from is not kept in sync, the model is the authoritative copy
+class WorldModel {
+    public:
+        WorldModel(GlobalData*);
+
+        shared_ptr<const WorldSnapshot> load() const { return atomic_load(&current); }
+
+        void setRobot(Vec);
+        void setBall(Vec);
+        void setEnemies(const vector<Vec>&);
+        // rebuilds the occupancy grid along with the obstacle list
+        void setObstacles(const vector<vector<Vec>>&);
+        // publishes a copy of an incrementally kept grid, with the cells it just changed
+        void setObstacleMap(const ObstacleMap&);
+
+        // applies edit to a copy of the current version and publishes it
+        template <typename Edit>
+        shared_ptr<const WorldSnapshot> update(Edit edit) {
+            lock_guard<mutex> lock(write_mutex);
+            auto next = make_shared<WorldSnapshot>(*atomic_load(&current));
+            edit(*next);
+            next->version++;
+            shared_ptr<const WorldSnapshot> published = next;
+            atomic_store(&current, published);
+            return published;
+        }
+
+    private:
+        double node_distance, width, height;
+        shared_ptr<const WorldSnapshot> current;
+        // only serializes writers against each other
+        mutex write_mutex;
+};
+
+#endif
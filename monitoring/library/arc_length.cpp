@@ -0,0 +1,50 @@
+#include "arc_length.hpp"
+
+#include <algorithm>
+
+void ArcLengthTable::build(const vector<Vec>& points_) {
+  points = points_;
+  cumulative.resize(points.size());
+  double length = 0;
+  for (size_t i = 0; i < points.size(); i++) {
+    if (i > 0) length += (points[i] - points[i-1]).len();
+    cumulative[i] = length;
+  }
+}
+
+size_t ArcLengthTable::segmentAt(double s) {
+  // last sample whose cumulative length does not exceed s
+  auto it = upper_bound(cumulative.begin(), cumulative.end(), s);
+  if (it == cumulative.begin()) return 0;
+  size_t index = it - cumulative.begin() - 1;
+  return min(index, points.size() > 1 ? points.size() - 2 : 0);
+}
+
+Vec ArcLengthTable::at(double s) {
+  if (points.empty()) return Vec();
+  if (points.size() == 1 || s <= 0) return points.front();
+  if (s >= getLength()) return points.back();
+  size_t i = segmentAt(s);
+  double segment = cumulative[i+1] - cumulative[i];
+  double ratio = segment > 0 ? (s - cumulative[i]) / segment : 0;
+  return points[i] + (points[i+1] - points[i]) * ratio;
+}
+
+vector<Vec> ArcLengthTable::resample(double spacing) {
+  if (points.size() < 2 || spacing <= 0) return points;
+  double length = getLength();
+  int count = max(1, static_cast<int>(ceil(length / spacing)));
+  vector<Vec> result(count + 1);
+  // stretch the spacing slightly so the last sample lands on the end point
+  double step = length / count;
+  size_t i = 0;
+  for (int k = 0; k <= count; k++) {
+    double s = k * step;
+    while (i + 2 < points.size() && cumulative[i+1] < s) i++;
+    double segment = cumulative[i+1] - cumulative[i];
+    double ratio = segment > 0 ? min(1.0, max(0.0, (s - cumulative[i]) / segment)) : 0;
+    result[k] = points[i] + (points[i+1] - points[i]) * ratio;
+  }
+  result.back() = points.back();
+  return result;
+}
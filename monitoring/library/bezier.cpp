@@ -0,0 +1,171 @@
+#include "bezier.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BEZIER_X86
+#endif
+
+const size_t TABLE_CACHE_SIZE = 8;
+const size_t SIMD_WIDTH = 4;
+const int MAX_SUBDIVISION_DEPTH = 16;
+
+typedef void (*DotKernel)(const double*, const double*, const double*, size_t, double&, double&);
+
+// BernsteinTable implementation
+BernsteinTable::BernsteinTable(int degree_, int numPoints_) {
+  degree = degree_;
+  numPoints = numPoints_;
+  stride = (degree + SIMD_WIDTH) / SIMD_WIDTH * SIMD_WIDTH;
+  basis.assign((numPoints + 1) * stride, 0.0);
+  // triangular recurrence only forms convex combinations, so high degrees stay stable
+  for (int i = 0; i <= numPoints; i++) {
+    double t = static_cast<double>(i) / numPoints;
+    double *row = &basis[i * stride];
+    row[0] = 1;
+    for (int r = 1; r <= degree; r++) {
+      for (int k = r; k > 0; k--) row[k] = row[k] * (1 - t) + row[k-1] * t;
+      row[0] *= 1 - t;
+    }
+  }
+}
+
+// dot product kernels, x and y are zero padded to the table stride
+static void dotScalar(const double* row, const double* x, const double* y, size_t stride, double& sx, double& sy) {
+  double ax = 0, ay = 0;
+  for (size_t k = 0; k < stride; k++) {
+    ax += row[k] * x[k];
+    ay += row[k] * y[k];
+  }
+  sx = ax;
+  sy = ay;
+}
+
+#ifdef BEZIER_X86
+static void dotSse(const double* row, const double* x, const double* y, size_t stride, double& sx, double& sy) {
+  __m128d ax = _mm_setzero_pd(), ay = _mm_setzero_pd();
+  for (size_t k = 0; k < stride; k += 2) {
+    __m128d b = _mm_loadu_pd(row + k);
+    ax = _mm_add_pd(ax, _mm_mul_pd(b, _mm_loadu_pd(x + k)));
+    ay = _mm_add_pd(ay, _mm_mul_pd(b, _mm_loadu_pd(y + k)));
+  }
+  double tx[2], ty[2];
+  _mm_storeu_pd(tx, ax);
+  _mm_storeu_pd(ty, ay);
+  sx = tx[0] + tx[1];
+  sy = ty[0] + ty[1];
+}
+
+__attribute__((target("avx2,fma")))
+static void dotAvx2(const double* row, const double* x, const double* y, size_t stride, double& sx, double& sy) {
+  __m256d ax = _mm256_setzero_pd(), ay = _mm256_setzero_pd();
+  for (size_t k = 0; k < stride; k += 4) {
+    __m256d b = _mm256_loadu_pd(row + k);
+    ax = _mm256_fmadd_pd(b, _mm256_loadu_pd(x + k), ax);
+    ay = _mm256_fmadd_pd(b, _mm256_loadu_pd(y + k), ay);
+  }
+  double tx[4], ty[4];
+  _mm256_storeu_pd(tx, ax);
+  _mm256_storeu_pd(ty, ay);
+  sx = (tx[0] + tx[1]) + (tx[2] + tx[3]);
+  sy = (ty[0] + ty[1]) + (ty[2] + ty[3]);
+}
+#endif
+
+static DotKernel selectKernel(const char** name) {
+#ifdef BEZIER_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    *name = "avx2";
+    return dotAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    *name = "sse2";
+    return dotSse;
+  }
+#endif
+  *name = "scalar";
+  return dotScalar;
+}
+
+static const char* kernel_name = "scalar";
+static DotKernel dot_kernel = selectKernel(&kernel_name);
+
+// BezierEvaluator implementation
+const char* BezierEvaluator::getKernelName() {
+  return kernel_name;
+}
+
+BernsteinTable& BezierEvaluator::getTable(int degree, int numPoints) {
+  for (auto it = cache.begin(); it != cache.end(); it++) {
+    if (it->degree == degree && it->numPoints == numPoints) {
+      cache.splice(cache.begin(), cache, it);
+      return cache.front();
+    }
+  }
+  cache.emplace_front(degree, numPoints);
+  if (cache.size() > TABLE_CACHE_SIZE) cache.pop_back();
+  return cache.front();
+}
+
+void BezierEvaluator::loadControl(const vector<Vec>& control, size_t stride, vector<double>& x, vector<double>& y) {
+  x.assign(stride, 0.0);
+  y.assign(stride, 0.0);
+  for (size_t k = 0; k < control.size(); k++) {
+    x[k] = control[k].x;
+    y[k] = control[k].y;
+  }
+}
+
+void BezierEvaluator::evaluate(const vector<Vec>& control, int numPoints, vector<Vec>& result) {
+  result.clear();
+  if (control.empty() || numPoints <= 0) {
+    result = control;
+    return;
+  }
+  BernsteinTable &table = getTable(control.size()-1, numPoints);
+  loadControl(control, table.stride, control_x, control_y);
+  result.resize(numPoints+1);
+  for (int i = 0; i <= numPoints; i++) {
+    dot_kernel(&table.basis[i * table.stride], control_x.data(), control_y.data(), table.stride, result[i].x, result[i].y);
+  }
+}
+
+// adaptive subdivision
+static double flatness(const vector<Vec>& control) {
+  // the curve stays inside the control polygon's hull, so the farthest control point
+  // from the chord segment bounds its deviation from the chord
+  Vec start = control.front(), end = control.back();
+  Vec chord = end - start;
+  double squared = chord.x * chord.x + chord.y * chord.y;
+  double result = 0;
+  for (size_t k = 1; k + 1 < control.size(); k++) {
+    Vec offset = Vec(control[k]) - start;
+    double t = squared > 1e-18 ? max(0.0, min(1.0, (offset.x * chord.x + offset.y * chord.y) / squared)) : 0;
+    result = max(result, (offset - chord * t).len());
+  }
+  return result;
+}
+
+static void subdivide(const vector<Vec>& control, double tolerance, int depth, vector<Vec>& result) {
+  if (depth >= MAX_SUBDIVISION_DEPTH || flatness(control) <= tolerance) {
+    result.push_back(control.back());
+    return;
+  }
+  // de Casteljau at the midpoint, the triangle edges are the two halves' control points
+  size_t n = control.size();
+  vector<Vec> level = control, left(n), right(n);
+  for (size_t r = 0; r < n; r++) {
+    left[r] = level[0];
+    right[n-1-r] = level[n-1-r];
+    for (size_t k = 0; k + 1 < n - r; k++) level[k] = (level[k] + level[k+1]) * 0.5;
+  }
+  subdivide(left, tolerance, depth + 1, result);
+  subdivide(right, tolerance, depth + 1, result);
+}
+
+void subdivideBezier(const vector<Vec>& control, double tolerance, vector<Vec>& result) {
+  if (control.empty()) return;
+  if (result.empty() || !(result.back() == control.front())) result.push_back(control.front());
+  if (control.size() < 2) return;
+  subdivide(control, max(tolerance, 1e-6), 0, result);
+}
@@ -0,0 +1,156 @@
+#include "fillet.hpp"
+
+#include <algorithm>
+
+const double MIN_FILLET_RATIO = 0.25;
+
+// PathPiece implementation
+Vec PathPiece::at(double s) {
+  double ratio = length > 0 ? min(1.0, max(0.0, s / length)) : 0;
+  if (radius <= 0) return start + (end - start) * ratio;
+  double angle = start_angle + sweep * ratio;
+  return center + Vec(cos(angle), sin(angle)) * radius;
+}
+
+// FilletPath implementation
+void FilletPath::addLine(Vec start, Vec end) {
+  PathPiece piece;
+  piece.start = start;
+  piece.end = end;
+  piece.length = (end - start).len();
+  if (piece.length <= 1e-9) return;
+  offsets.push_back(getLength());
+  pieces.push_back(piece);
+}
+
+bool FilletPath::arcClear(const OccupancyGrid& grid, PathPiece& arc) {
+  int count = max(2, static_cast<int>(ceil(arc.length / (grid.getNodeDistance() / 2))));
+  for (int i = 0; i <= count; i++) {
+    if (grid.blocked(arc.at(arc.length * i / count))) return false;
+  }
+  return true;
+}
+
+void FilletPath::build(const OccupancyGrid& grid, const vector<Vec>& vertices_, double turn_radius) {
+  pieces.clear();
+  offsets.clear();
+  shrunk = 0;
+  vector<Vec> v = vertices_;
+  if (v.size() < 2) {
+    if (!v.empty()) addLine(v[0], v[0]);
+    return;
+  }
+
+  Vec cursor = v[0];
+  size_t n = v.size() - 1;
+  for (size_t k = 1; k < n; k++) {
+    Vec in = v[k] - v[k-1], out = v[k+1] - v[k];
+    double in_len = in.len(), out_len = out.len();
+    if (in_len <= 1e-9 || out_len <= 1e-9) continue;
+    Vec d1 = in / in_len, d2 = out / out_len;
+    double cross = d1.x * d2.y - d1.y * d2.x;
+    double turn = acos(min(1.0, max(-1.0, d1.x * d2.x + d1.y * d2.y)));
+    if (turn < 1e-6 || turn > M_PI - 1e-6) continue;
+
+    // inner segments are shared by two fillets, each may use half of it
+    double tan_half = tan(turn / 2);
+    double available = min(in_len * (k == 1 ? 1 : 0.5), out_len * (k == n - 1 ? 1 : 0.5));
+    available = min(available, (v[k] - cursor).len());
+    double radius = min(turn_radius, available / tan_half);
+    if (radius < turn_radius) shrunk++;
+
+    PathPiece arc;
+    bool fitted = false;
+    // tighten the arc toward the corner until it clears the inflated obstacles
+    while (radius >= grid.getNodeDistance() * MIN_FILLET_RATIO) {
+      double tangent = radius * tan_half;
+      arc.start = v[k] - d1 * tangent;
+      arc.end = v[k] + d2 * tangent;
+      Vec normal = cross > 0 ? Vec(-d1.y, d1.x) : Vec(d1.y, -d1.x);
+      arc.center = arc.start + normal * radius;
+      arc.radius = radius;
+      arc.start_angle = atan2(arc.start.y - arc.center.y, arc.start.x - arc.center.x);
+      arc.sweep = cross > 0 ? turn : -turn;
+      arc.length = radius * turn;
+      if (arcClear(grid, arc)) {
+        fitted = true;
+        break;
+      }
+      radius /= 2;
+      shrunk++;
+    }
+    if (!fitted) {
+      // the pulled corner itself is clear, keep it sharp
+      addLine(cursor, v[k]);
+      cursor = v[k];
+      continue;
+    }
+    addLine(cursor, arc.start);
+    offsets.push_back(getLength());
+    pieces.push_back(arc);
+    cursor = arc.end;
+  }
+  addLine(cursor, v[n]);
+  if (pieces.empty()) addLine(v[0], v[n]);
+}
+
+Vec FilletPath::at(double s) {
+  if (pieces.empty()) return Vec();
+  auto it = upper_bound(offsets.begin(), offsets.end(), s);
+  size_t index = it == offsets.begin() ? 0 : it - offsets.begin() - 1;
+  return pieces[index].at(s - offsets[index]);
+}
+
+vector<Vec> FilletPath::sample(double spacing) {
+  vector<Vec> result;
+  if (pieces.empty()) return result;
+  double length = getLength();
+  int count = max(1, static_cast<int>(ceil(length / max(spacing, 1e-6))));
+  result.resize(count + 1);
+  size_t index = 0;
+  for (int i = 0; i <= count; i++) {
+    double s = length * i / count;
+    while (index + 1 < pieces.size() && offsets[index + 1] <= s) index++;
+    result[i] = pieces[index].at(s - offsets[index]);
+  }
+  result.back() = pieces.back().end;
+  return result;
+}
+
+vector<Vec> FilletPath::sampleAdaptive(double tolerance) {
+  vector<Vec> result;
+  if (pieces.empty()) return result;
+  result.push_back(pieces.front().start);
+  for (auto &piece : pieces) {
+    if (piece.radius > 0) {
+      // sagitta r * (1 - cos(step / 2)) stays below the tolerance
+      double ratio = max(-1.0, 1 - tolerance / piece.radius);
+      double step = 2 * acos(ratio);
+      int count = max(1, static_cast<int>(ceil(fabs(piece.sweep) / max(step, 1e-6))));
+      for (int i = 1; i < count; i++) result.push_back(piece.at(piece.length * i / count));
+    }
+    result.push_back(piece.end);
+  }
+  return result;
+}
+
+// string pulling
+bool lineOfSight(const OccupancyGrid& grid, Vec from, Vec to) {
+  return grid.segmentClear(from, to, false, false);
+}
+
+vector<Vec> pullString(const OccupancyGrid& grid, const vector<Vec>& path) {
+  if (path.size() < 3) return path;
+  vector<Vec> result;
+  result.push_back(path[0]);
+  size_t anchor = 0;
+  for (size_t i = 1; i + 1 < path.size(); i++) {
+    // neighbours on the grid path always see each other, only skipping needs a check
+    if (!lineOfSight(grid, path[anchor], path[i+1])) {
+      result.push_back(path[i]);
+      anchor = i;
+    }
+  }
+  result.push_back(path.back());
+  return result;
+}
@@ -0,0 +1,217 @@
+#include "message.hpp"
+
+#include <cstring>
+#include <nlohmann/json.hpp>
+
+using nlohmann::json;
+
+const int MAX_MESSAGE_DEPTH = 8;
+
+enum MessageKey {
+    KEY_NONE = 0,
+    KEY_X,
+    KEY_Y,
+    KEY_DIR,
+    KEY_TYPE,
+    KEY_VALUE,
+    KEY_TARGET,
+    KEY_PROTOCOL,
+    KEY_FORMAT,
+    KEY_FORMATS,
+    KEY_ID,
+    KEY_LOCAL,
+    KEY_PLAN_US,
+    KEY_LATENCY_US,
+    KEY_TIME,
+    KEY_PLANNED,
+    KEY_SEQ,
+    KEY_BASE,
+    KEY_RADIUS,
+    KEY_CENTERS,
+    KEY_REASON
+};
+
+// the hot keys come first
+static const char* const KEY_NAMES[] = {
+  "", "x", "y", "dir", "type", "value", "target", "protocol", "format", "formats",
+  "id", "local", "plan_us", "latency_us", "time", "planned", "seq", "base", "radius", "centers",
+  "reason"
+};
+
+static const char* const TYPE_NAMES[] = {
+  "", "hello", "run", "target", "neighbors", "obstacles", "obstacles_ack", "position",
+  "astar_path", "bezier_path", "plan_stats", "finished"
+};
+
+template <size_t N>
+static int lookup(const char* const (&names)[N], const json::string_t& value) {
+  for (size_t k = 1; k < N; k++) {
+    if (value.size() == strlen(names[k]) && value.compare(names[k]) == 0) return k;
+  }
+  return 0;
+}
+
+static void setPoint(Vec& point, int key, double value) {
+  if (key == KEY_X) point.x = value;
+  else if (key == KEY_Y) point.y = value;
+}
+
+// nlohmann SAX handler, tracks the member key of every open object so each
+// scalar lands in its field by position, members it does not know are skipped
+class MessageReader {
+  public:
+    MessageReader(Message& message): message(message) {}
+
+    bool null() { return true; }
+    bool boolean(bool value) { return number(value); }
+    bool number_integer(json::number_integer_t value) { return number(value); }
+    bool number_unsigned(json::number_unsigned_t value) { return number(value); }
+    bool number_float(json::number_float_t value, const json::string_t&) { return number(value); }
+    template <typename Binary>
+    bool binary(Binary&) { return true; }
+
+    bool string(json::string_t& value) {
+      if (depth == 1) {
+        if (keys[0] == KEY_TYPE) message.type = lookup(TYPE_NAMES, value);
+        else if (keys[0] == KEY_FORMAT) message.binary = value == "binary";
+        else if (keys[0] == KEY_VALUE) message.start = value == "start";
+      } else if (depth == 2 && !arrays[1] && keys[0] == KEY_VALUE && keys[1] == KEY_REASON) {
+        message.reason = value;
+      } else if (depth == 2 && arrays[1] && keys[0] == KEY_FORMATS) {
+        if (value == "binary") message.binary = true;
+      }
+      return true;
+    }
+
+    bool start_object(size_t) {
+      if (depth == 1 && keys[0] == KEY_VALUE) message.has_value = true;
+      else if (inValue() && depth == 2 && arrays[1]) {
+        // a point until one of its keys says it is a shape
+        message.points.emplace_back();
+        element_shape = false;
+      } else if (inCenters() && depth == 4) {
+        message.shapes.back().centers.emplace_back();
+      }
+      return push(false);
+    }
+
+    bool start_array(size_t) { return push(true); }
+
+    bool key(json::string_t& value) {
+      if (depth > MAX_MESSAGE_DEPTH) return true;
+      int key = lookup(KEY_NAMES, value);
+      keys[depth-1] = key;
+      if (inValue() && depth == 3 && arrays[1] && !arrays[2] && !element_shape && (key == KEY_ID || key == KEY_CENTERS)) {
+        element_shape = true;
+        message.points.pop_back();
+        message.shapes.emplace_back();
+      }
+      return true;
+    }
+
+    bool end_object() { depth--; return true; }
+    bool end_array() { depth--; return true; }
+
+    bool parse_error(size_t, const std::string&, const nlohmann::detail::exception&) { return false; }
+
+  private:
+    Message& message;
+    int depth = 0;
+    int keys[MAX_MESSAGE_DEPTH];
+    bool arrays[MAX_MESSAGE_DEPTH];
+    // the current element of a value array is an enemy shape
+    bool element_shape = false;
+
+    bool inValue() { return depth >= 1 && keys[0] == KEY_VALUE; }
+    bool inCenters() {
+      return inValue() && element_shape && depth >= 4 && arrays[1] && !arrays[2] && arrays[3] && keys[2] == KEY_CENTERS;
+    }
+
+    bool push(bool array) {
+      if (depth < MAX_MESSAGE_DEPTH) {
+        arrays[depth] = array;
+        keys[depth] = KEY_NONE;
+      }
+      depth++;
+      return true;
+    }
+
+    bool number(double value) {
+      if (depth == 1) {
+        switch (keys[0]) {
+          case KEY_PROTOCOL: message.protocol = static_cast<int>(value); break;
+          case KEY_SEQ: message.sequence = static_cast<unsigned int>(value); break;
+          case KEY_BASE: message.base = static_cast<unsigned int>(value); break;
+          case KEY_RADIUS: message.radius = value; break;
+          default: break;
+        }
+      } else if (depth == 2 && keys[0] == KEY_TARGET && !arrays[1]) {
+        message.has_target = true;
+        setPoint(message.target, keys[1], value);
+      } else if (inValue() && depth == 2 && !arrays[1]) {
+        switch (keys[1]) {
+          case KEY_X: message.pose.x = value; break;
+          case KEY_Y: message.pose.y = value; break;
+          case KEY_DIR: message.pose.dir = value; break;
+          case KEY_ID: message.id = static_cast<unsigned int>(value); break;
+          case KEY_LOCAL: message.local = value != 0; break;
+          case KEY_PLAN_US: message.plan_us = value; break;
+          case KEY_LATENCY_US: message.latency_us = value; break;
+          case KEY_TIME: message.time = value; break;
+          case KEY_PLANNED: message.planned = value; break;
+          default: break;
+        }
+      } else if (inValue() && depth == 3 && !arrays[1] && !arrays[2] && keys[1] == KEY_TARGET) {
+        if (keys[2] == KEY_X) message.pose.target_x = value;
+        else if (keys[2] == KEY_Y) message.pose.target_y = value;
+      } else if (inValue() && depth == 3 && arrays[1] && !arrays[2] && element_shape) {
+        if (keys[2] == KEY_ID) message.shapes.back().id = static_cast<int>(value);
+      } else if (inValue() && depth == 3 && arrays[1] && !arrays[2] && !message.points.empty()) {
+        setPoint(message.points.back(), keys[2], value);
+      } else if (inCenters() && depth == 5 && !arrays[4] && !message.shapes.back().centers.empty()) {
+        setPoint(message.shapes.back().centers.back(), keys[4], value);
+      }
+      return true;
+    }
+};
+
+void Message::clear() {
+  type = MESSAGE_UNKNOWN;
+  protocol = 0;
+  binary = false;
+  start = false;
+  has_target = false;
+  target = Vec();
+  pose = PoseFrame();
+  points.clear();
+  sequence = base = 0;
+  radius = 0;
+  shapes.clear();
+  has_value = false;
+  id = 0;
+  local = false;
+  plan_us = latency_us = 0;
+  reason.clear();
+  time = planned = 0;
+}
+
+bool decodeMessage(const char* data, size_t size, Message& message) {
+  message.clear();
+  MessageReader reader(message);
+  if (!json::sax_parse(data, data + size, &reader)) return false;
+  // the target message sends its point as value
+  if (message.type == MESSAGE_TARGET && message.has_value) {
+    message.has_target = true;
+    message.target = Vec(message.pose.x, message.pose.y);
+  }
+  return true;
+}
+
+int messageFrame(int type) {
+  switch (type) {
+    case MESSAGE_POSITION: return FRAME_POSE;
+    case MESSAGE_ASTAR_PATH: return FRAME_ASTAR_PATH;
+    case MESSAGE_BEZIER_PATH: return FRAME_BEZIER_PATH;
+    default: return -1;
+  }
+}
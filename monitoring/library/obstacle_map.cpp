@@ -0,0 +1,213 @@
+#include "obstacle_map.hpp"
+#include "tracker.hpp"
+
+#include <set>
+#include <algorithm>
+
+static bool pointInField(Vec point, double width, double height) {
+  return point.x >= 0 && point.x <= width && point.y >= 0 && point.y <= height;
+}
+
+ObstacleParameters makeObstacleParameters(GlobalData* global) {
+  ObstacleParameters params;
+  params.radius = global->robot_radius;
+  params.node_distance = global->node_distance;
+  params.width = global->screen_width;
+  params.height = global->screen_height;
+  return params;
+}
+
+vector<EnemyShape> trackedShapes(GlobalData* global, const vector<Vec>& enemies, double now) {
+  vector<EnemyShape> shapes;
+  for (size_t index = 0; index < enemies.size(); index++) {
+    EnemyShape shape;
+    shape.id = index;
+    shape.centers.push_back(enemies[index]);
+    // inflate along the predicted motion instead of the last known position only
+    if (global->prediction_horizon > 0 && global->tracker->hasTrack(index)) {
+      double speed = global->tracker->getTrack(index)->getVelocity().len();
+      double step = speed > 0 ? max(global->node_distance / speed, global->prediction_horizon / 20) : global->prediction_horizon;
+      for (auto &center : global->tracker->predictPath(index, now, global->prediction_horizon, step)) {
+        shape.centers.push_back(center);
+      }
+    }
+    shapes.push_back(shape);
+  }
+  return shapes;
+}
+
+void rasterizeShape(const EnemyShape& shape, const ObstacleParameters& params, vector<Vec>& obstacle, vector<Vec>& visible) {
+  double nd = params.node_distance;
+  int offset = static_cast<int>(params.radius / nd + 1);
+  set<pair<int, int>> cells;
+  for (size_t k = 0; k < shape.centers.size(); k++) {
+    Vec center = shape.centers[k];
+    Vec temp_point{
+        static_cast<int>(center.x / nd) * nd,
+        static_cast<int>(center.y / nd) * nd
+    };
+    for (int i = -offset; i <= offset; i++) {
+      for (int j = -offset; j <= offset; j++) {
+        Vec neighbor = temp_point + Vec{i * nd, j * nd};
+        Vec delta = center - neighbor;
+        if (!pointInField(neighbor, params.width, params.height)) continue;
+        pair<int, int> cell{static_cast<int>(round(neighbor.x / nd)), static_cast<int>(round(neighbor.y / nd))};
+        if (delta.len() <= params.radius && cells.insert(cell).second) obstacle.push_back(neighbor);
+        if (k == 0 && delta.len() <= params.radius/2) visible.push_back(neighbor);
+      }
+    }
+  }
+}
+
+void rasterizeShapes(const vector<EnemyShape>& shapes, const ObstacleParameters& params,
+                     vector<vector<Vec>>& obstacles, vector<vector<Vec>>& visible) {
+  obstacles.clear();
+  visible.clear();
+  for (auto &shape : shapes) {
+    obstacles.emplace_back();
+    visible.emplace_back();
+    rasterizeShape(shape, params, obstacles.back(), visible.back());
+  }
+}
+
+bool shapeChanged(const EnemyShape& a, const EnemyShape& b, double tolerance) {
+  if (a.centers.size() != b.centers.size()) return true;
+  for (size_t k = 0; k < a.centers.size(); k++) {
+    if ((a.centers[k] - b.centers[k]).len() > tolerance) return true;
+  }
+  return false;
+}
+
+// ObstacleMap implementation
+ObstacleMap::ObstacleMap(const ObstacleParameters& params): params(params) {
+  reset();
+}
+
+void ObstacleMap::reset() {
+  grid.resize(params.node_distance, params.width, params.height);
+  coverage.assign(grid.getSize(), 0);
+  shapes.clear();
+  obstacles.clear();
+  enemy_cells.clear();
+  changed.clear();
+  rasterized = 0;
+}
+
+void ObstacleMap::cover(size_t cell, int delta) {
+  // only a count crossing zero can flip the cell
+  if (coverage[cell] == 0 || coverage[cell] + delta == 0) touched.push_back(cell);
+  coverage[cell] += delta;
+}
+
+void ObstacleMap::remove(int id) {
+  for (size_t cell : enemy_cells[id]) cover(cell, -1);
+  enemy_cells[id].clear();
+  obstacles[id].clear();
+  shapes[id].centers.clear();
+}
+
+void ObstacleMap::apply(const vector<EnemyShape>& update, double radius, bool replace) {
+  touched.clear();
+  changed.clear();
+  rasterized = 0;
+
+  vector<EnemyShape> pending = update;
+  vector<bool> named(shapes.size(), false);
+  for (auto &shape : update) {
+    if (shape.id >= 0 && static_cast<size_t>(shape.id) < named.size()) named[shape.id] = true;
+  }
+  bool resized = radius != params.radius;
+  params.radius = radius;
+  for (size_t id = 0; id < shapes.size(); id++) {
+    if (named[id] || shapes[id].centers.empty()) continue;
+    if (replace) remove(id);
+    else if (resized) pending.push_back(shapes[id]);
+  }
+
+  vector<Vec> visible;
+  for (auto &shape : pending) {
+    if (shape.id < 0) continue;
+    size_t id = shape.id;
+    if (id >= shapes.size()) {
+      shapes.resize(id + 1);
+      obstacles.resize(id + 1);
+      enemy_cells.resize(id + 1);
+    }
+    remove(id);
+    rasterizeShape(shape, params, obstacles[id], visible);
+    for (auto &point : obstacles[id]) {
+      int i, j;
+      grid.toCell(point, i, j);
+      if (!grid.inside(i, j)) continue;
+      enemy_cells[id].push_back(grid.index(i, j));
+      cover(grid.index(i, j), 1);
+    }
+    shapes[id] = shape;
+    rasterized++;
+  }
+
+  // a cell removed and covered again in the same update did not change
+  sort(touched.begin(), touched.end());
+  touched.erase(unique(touched.begin(), touched.end()), touched.end());
+  int cols = grid.getCols();
+  for (size_t cell : touched) {
+    int i = cell % cols, j = cell / cols;
+    Vec point = grid.toPoint(i, j);
+    bool border = point.x <= 0 || point.x >= params.width || point.y <= 0 || point.y >= params.height;
+    bool blocked = border || coverage[cell] > 0;
+    if (blocked == grid.blocked(i, j)) continue;
+    grid.set(i, j, blocked);
+    changed.push_back(cell);
+  }
+}
+
+// ObstacleSync implementation
+bool ObstacleSync::delta(const vector<EnemyShape>& shapes, double radius, vector<EnemyShape>& changed,
+                         unsigned int& sequence, unsigned int& base) {
+  if (sent.size() >= MAX_IN_FLIGHT) reset();
+  changed.clear();
+  vector<int> ids;
+  bool full = acknowledged == 0 || radius != acknowledged_radius || shapes.size() != acknowledged_shapes.size();
+  if (full) {
+    changed = shapes;
+    base = 0;
+  } else {
+    set<int> in_flight;
+    for (auto &item : sent) in_flight.insert(item.second.ids.begin(), item.second.ids.end());
+    for (auto &shape : shapes) {
+      const EnemyShape *previous = nullptr;
+      for (auto &item : acknowledged_shapes) {
+        if (item.id == shape.id) previous = &item;
+      }
+      if (!previous || in_flight.count(shape.id) || shapeChanged(*previous, shape, SHAPE_TOLERANCE)) {
+        changed.push_back(shape);
+      }
+    }
+    if (changed.empty()) return false;
+    base = acknowledged;
+  }
+  for (auto &shape : changed) ids.push_back(shape.id);
+  sequence = ++last_sequence;
+  sent[sequence] = Sent{shapes, ids, radius};
+  return true;
+}
+
+void ObstacleSync::acknowledge(unsigned int sequence) {
+  auto it = sent.find(sequence);
+  if (it == sent.end()) {
+    // the robot lost its map and asks for everything again
+    if (sequence == 0) reset();
+    return;
+  }
+  acknowledged = sequence;
+  acknowledged_shapes = it->second.shapes;
+  acknowledged_radius = it->second.radius;
+  sent.erase(sent.begin(), next(it));
+}
+
+void ObstacleSync::reset() {
+  acknowledged = 0;
+  acknowledged_shapes.clear();
+  acknowledged_radius = 0;
+  sent.clear();
+}
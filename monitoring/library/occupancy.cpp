@@ -0,0 +1,99 @@
+#include "occupancy.hpp"
+
+OccupancyGrid::OccupancyGrid(double node_distance, double width, double height) {
+  resize(node_distance, width, height);
+}
+
+void OccupancyGrid::resize(double node_distance_, double width_, double height_) {
+  node_distance = node_distance_;
+  width = width_;
+  height = height_;
+  cols = static_cast<int>(width / node_distance) + 1;
+  rows = static_cast<int>(height / node_distance) + 1;
+  cells.assign(static_cast<size_t>(cols) * rows, 0);
+  clear();
+}
+
+void OccupancyGrid::clear() {
+  // the field border is never walkable
+  for (int j = 0; j < rows; j++) {
+    for (int i = 0; i < cols; i++) {
+      Vec point = toPoint(i, j);
+      cells[index(i, j)] = point.x <= 0 || point.x >= width || point.y <= 0 || point.y >= height;
+    }
+  }
+  version++;
+}
+
+void OccupancyGrid::build(const vector<vector<Vec>>& obstacles) {
+  clear();
+  for (auto &item : obstacles) {
+    for (auto &obstacle : item) {
+      int i, j;
+      toCell(obstacle, i, j);
+      if (inside(i, j)) cells[index(i, j)] = 1;
+    }
+  }
+}
+
+void OccupancyGrid::set(int i, int j, bool value) {
+  if (!inside(i, j)) return;
+  cells[index(i, j)] = value;
+  version++;
+}
+
+bool OccupancyGrid::blocked(Vec point) const {
+  int i, j;
+  toCell(point, i, j);
+  return blocked(i, j);
+}
+
+bool OccupancyGrid::segmentClear(Vec from, Vec to, bool check_from, bool check_to) const {
+  // shift by half a cell so the squares owned by the nodes become unit cells
+  double nd = node_distance;
+  double x0 = from.x / nd + 0.5, y0 = from.y / nd + 0.5;
+  double x1 = to.x / nd + 0.5, y1 = to.y / nd + 0.5;
+  int i = static_cast<int>(floor(x0)), j = static_cast<int>(floor(y0));
+  int end_i = static_cast<int>(floor(x1)), end_j = static_cast<int>(floor(y1));
+  int first_i = i, first_j = j;
+  double dx = x1 - x0, dy = y1 - y0;
+  int step_i = dx > 0 ? 1 : -1, step_j = dy > 0 ? 1 : -1;
+  double delta_x = dx != 0 ? fabs(1 / dx) : INFINITY;
+  double delta_y = dy != 0 ? fabs(1 / dy) : INFINITY;
+  double next_x = dx > 0 ? (i + 1 - x0) / dx : dx < 0 ? (x0 - i) / -dx : INFINITY;
+  double next_y = dy > 0 ? (j + 1 - y0) / dy : dy < 0 ? (y0 - j) / -dy : INFINITY;
+
+  auto check = [&](int ci, int cj) {
+    if ((!check_from && ci == first_i && cj == first_j) || (!check_to && ci == end_i && cj == end_j)) return true;
+    return !blocked(ci, cj);
+  };
+
+  if (!check(i, j)) return false;
+  int remaining = abs(end_i - i) + abs(end_j - j);
+  while (remaining > 0) {
+    if (fabs(next_x - next_y) < 1e-9 && i != end_i && j != end_j) {
+      // passing exactly through a corner touches both side cells
+      if (!check(i + step_i, j) || !check(i, j + step_j)) return false;
+      i += step_i;
+      j += step_j;
+      next_x += delta_x;
+      next_y += delta_y;
+      remaining -= 2;
+    } else if (next_x < next_y) {
+      i += step_i;
+      next_x += delta_x;
+      remaining--;
+    } else {
+      j += step_j;
+      next_y += delta_y;
+      remaining--;
+    }
+    if (!check(i, j)) return false;
+  }
+  return true;
+}
+
+void OccupancyGrid::toCell(Vec point, int& i, int& j) const {
+  i = static_cast<int>(round(point.x / node_distance));
+  j = static_cast<int>(round(point.y / node_distance));
+}
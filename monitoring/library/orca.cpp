@@ -0,0 +1,231 @@
+#include "orca.hpp"
+
+#include <chrono>
+
+const double ORCA_EPSILON = 1e-5;
+
+// vector helpers
+static double dot(Vec a, Vec b) {
+  return a.x * b.x + a.y * b.y;
+}
+
+static double det(Vec a, Vec b) {
+  return a.x * b.y - a.y * b.x;
+}
+
+static double lenSq(Vec a) {
+  return a.x * a.x + a.y * a.y;
+}
+
+// SpatialHash implementation
+long long SpatialHash::key(int i, int j) {
+  return (static_cast<long long>(i) << 32) ^ static_cast<unsigned int>(j);
+}
+
+void SpatialHash::build(const vector<Agent>& agents, double cell_size_) {
+  cell_size = cell_size_ > 0 ? cell_size_ : 1;
+  for (auto &cell : cells) cell.second.clear();
+  positions.clear();
+  for (size_t i = 0; i < agents.size(); i++) {
+    Vec pos = agents[i].position;
+    positions.push_back(pos);
+    cells[key(floor(pos.x / cell_size), floor(pos.y / cell_size))].push_back(i);
+  }
+}
+
+void SpatialHash::query(Vec pos, double range, vector<size_t>& result) {
+  result.clear();
+  int min_i = floor((pos.x - range) / cell_size), max_i = floor((pos.x + range) / cell_size);
+  int min_j = floor((pos.y - range) / cell_size), max_j = floor((pos.y + range) / cell_size);
+  for (int i = min_i; i <= max_i; i++) {
+    for (int j = min_j; j <= max_j; j++) {
+      auto it = cells.find(key(i, j));
+      if (it == cells.end()) continue;
+      for (size_t index : it->second) {
+        if (lenSq(positions[index] - pos) <= range * range) result.push_back(index);
+      }
+    }
+  }
+}
+
+// LocalAvoidance implementation
+LocalAvoidance::LocalAvoidance(double radius_, double max_speed_, double time_horizon_, double neighbor_distance_) {
+  radius = radius_;
+  max_speed = max_speed_;
+  time_horizon = time_horizon_;
+  neighbor_distance = neighbor_distance_;
+}
+
+void LocalAvoidance::updateNeighbors(const vector<Vec>& positions, double time) {
+  double dt = time - last_update;
+  if (last_update >= 0 && dt <= 0 && positions.size() == agents.size()) {
+    // several updates drained in the same step, the velocities stay as they are
+    for (size_t i = 0; i < positions.size(); i++) agents[i].position = positions[i];
+    hash.build(agents, neighbor_distance);
+    return;
+  }
+  if (last_update >= 0 && dt > 0 && positions.size() == agents.size()) {
+    for (size_t i = 0; i < positions.size(); i++) {
+      Vec measured = (Vec(positions[i]) - agents[i].position) / dt;
+      if (velocity_ready) agents[i].velocity = agents[i].velocity * 0.5 + measured * 0.5;
+      else agents[i].velocity = measured;
+      agents[i].position = positions[i];
+    }
+    velocity_ready = true;
+  } else {
+    velocity_ready = false;
+    agents.clear();
+    for (auto &position : positions) {
+      agents.push_back(Agent{position, Vec(0, 0), radius});
+    }
+  }
+  last_update = time;
+  hash.build(agents, neighbor_distance);
+}
+
+Vec LocalAvoidance::computeVelocity(Vec position, Vec velocity, Vec preferred, double time_step) {
+  auto start = chrono::steady_clock::now();
+  double inv_horizon = 1.0 / time_horizon;
+
+  orca_lines.clear();
+  hash.query(position, neighbor_distance, neighbors);
+  for (size_t index : neighbors) {
+    Agent &other = agents[index];
+    Vec rel_pos = other.position - position;
+    Vec rel_vel = velocity - other.velocity;
+    double dist_sq = lenSq(rel_pos);
+    double combined_radius = radius + other.radius;
+    double combined_radius_sq = combined_radius * combined_radius;
+
+    OrcaLine line;
+    Vec u;
+    if (dist_sq > combined_radius_sq) {
+      // no collision yet, project on cut-off circle or on a leg
+      Vec w = rel_vel - rel_pos * inv_horizon;
+      double w_len_sq = lenSq(w);
+      double dot_1 = dot(w, rel_pos);
+      if (dot_1 < 0 && dot_1 * dot_1 > combined_radius_sq * w_len_sq) {
+        double w_len = sqrt(w_len_sq);
+        Vec unit_w = w / w_len;
+        line.direction = Vec(unit_w.y, -unit_w.x);
+        u = unit_w * (combined_radius * inv_horizon - w_len);
+      } else {
+        double leg = sqrt(dist_sq - combined_radius_sq);
+        if (det(rel_pos, w) > 0) {
+          line.direction = Vec(
+            rel_pos.x * leg - rel_pos.y * combined_radius,
+            rel_pos.x * combined_radius + rel_pos.y * leg) / dist_sq;
+        } else {
+          line.direction = Vec(
+            rel_pos.x * leg + rel_pos.y * combined_radius,
+            -rel_pos.x * combined_radius + rel_pos.y * leg) / -dist_sq;
+        }
+        u = line.direction * dot(rel_vel, line.direction) - rel_vel;
+      }
+    } else {
+      // already overlapping, resolve within one step
+      double inv_step = 1.0 / time_step;
+      Vec w = rel_vel - rel_pos * inv_step;
+      double w_len = w.len();
+      if (w_len < ORCA_EPSILON) continue;
+      Vec unit_w = w / w_len;
+      line.direction = Vec(unit_w.y, -unit_w.x);
+      u = unit_w * (combined_radius * inv_step - w_len);
+    }
+    line.point = velocity + u * 0.5;
+    orca_lines.push_back(line);
+  }
+
+  Vec result;
+  size_t failed = linearProgram2(orca_lines, max_speed, preferred, false, result);
+  if (failed < orca_lines.size()) linearProgram3(orca_lines, failed, max_speed, result);
+
+  compute_time = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+bool LocalAvoidance::linearProgram1(const vector<OrcaLine>& lines, size_t line_no, double max_len, Vec opt_velocity, bool direction_opt, Vec& result) {
+  Vec point = lines[line_no].point, direction = lines[line_no].direction;
+  double dot_product = dot(point, direction);
+  double discriminant = dot_product * dot_product + max_len * max_len - lenSq(point);
+  if (discriminant < 0) return false;
+
+  double sqrt_discriminant = sqrt(discriminant);
+  double t_left = -dot_product - sqrt_discriminant;
+  double t_right = -dot_product + sqrt_discriminant;
+
+  for (size_t i = 0; i < line_no; i++) {
+    double denominator = det(direction, lines[i].direction);
+    double numerator = det(lines[i].direction, point - lines[i].point);
+    if (abs(denominator) <= ORCA_EPSILON) {
+      if (numerator < 0) return false;
+      continue;
+    }
+    double t = numerator / denominator;
+    if (denominator >= 0) t_right = min(t_right, t);
+    else t_left = max(t_left, t);
+    if (t_left > t_right) return false;
+  }
+
+  if (direction_opt) {
+    if (dot(opt_velocity, direction) > 0) result = point + direction * t_right;
+    else result = point + direction * t_left;
+  } else {
+    double t = dot(direction, opt_velocity - point);
+    if (t < t_left) t = t_left;
+    else if (t > t_right) t = t_right;
+    result = point + direction * t;
+  }
+  return true;
+}
+
+size_t LocalAvoidance::linearProgram2(const vector<OrcaLine>& lines, double max_len, Vec opt_velocity, bool direction_opt, Vec& result) {
+  if (direction_opt) {
+    result = opt_velocity * max_len;
+  } else if (lenSq(opt_velocity) > max_len * max_len) {
+    result = opt_velocity / opt_velocity.len() * max_len;
+  } else {
+    result = opt_velocity;
+  }
+
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (det(lines[i].direction, Vec(lines[i].point) - result) > 0) {
+      Vec temp = result;
+      if (!linearProgram1(lines, i, max_len, opt_velocity, direction_opt, result)) {
+        result = temp;
+        return i;
+      }
+    }
+  }
+  return lines.size();
+}
+
+void LocalAvoidance::linearProgram3(const vector<OrcaLine>& lines, size_t begin_line, double max_len, Vec& result) {
+  double distance = 0;
+  for (size_t i = begin_line; i < lines.size(); i++) {
+    OrcaLine current = lines[i];
+    if (det(current.direction, current.point - result) <= distance) continue;
+
+    projected.clear();
+    for (size_t j = 0; j < i; j++) {
+      OrcaLine line;
+      double determinant = det(current.direction, lines[j].direction);
+      if (abs(determinant) <= ORCA_EPSILON) {
+        if (dot(current.direction, lines[j].direction) > 0) continue;
+        line.point = (current.point + lines[j].point) * 0.5;
+      } else {
+        line.point = current.point + current.direction *
+          (det(lines[j].direction, current.point - lines[j].point) / determinant);
+      }
+      line.direction = Vec(lines[j].direction) - current.direction;
+      line.direction = line.direction / line.direction.len();
+      projected.push_back(line);
+    }
+
+    Vec temp = result;
+    if (linearProgram2(projected, max_len, Vec(-current.direction.y, current.direction.x), true, result) < projected.size()) {
+      result = temp;
+    }
+    distance = det(current.direction, current.point - result);
+  }
+}
@@ -0,0 +1,119 @@
+#include "path_follower.hpp"
+
+#include <algorithm>
+
+// segments scanned ahead of the monotone walk before falling back to the buckets
+const size_t SEARCH_WINDOW = 8;
+
+void PathFollower::setPath(const vector<Vec>& path) {
+  // no deduplication, indices stay those of the caller's path
+  points = path;
+  arcs.build(points);
+  index = 0;
+  progress = cross_track = 0;
+
+  buckets.clear();
+  bucket_cols = bucket_rows = 0;
+  if (points.size() < 2) return;
+  Vec lower = points[0], upper = points[0];
+  for (auto &point : points) {
+    lower = Vec(min(lower.x, point.x), min(lower.y, point.y));
+    upper = Vec(max(upper.x, point.x), max(upper.y, point.y));
+  }
+  origin = lower;
+  bucket_cols = static_cast<int>((upper.x - lower.x) / bucket_size) + 1;
+  bucket_rows = static_cast<int>((upper.y - lower.y) / bucket_size) + 1;
+  buckets.assign(static_cast<size_t>(bucket_cols) * bucket_rows, vector<size_t>());
+  for (size_t k = 0; k + 1 < points.size(); k++) {
+    int i0 = (min(points[k].x, points[k+1].x) - origin.x) / bucket_size;
+    int i1 = (max(points[k].x, points[k+1].x) - origin.x) / bucket_size;
+    int j0 = (min(points[k].y, points[k+1].y) - origin.y) / bucket_size;
+    int j1 = (max(points[k].y, points[k+1].y) - origin.y) / bucket_size;
+    for (int j = j0; j <= j1; j++) {
+      for (int i = i0; i <= i1; i++) buckets[j * bucket_cols + i].push_back(k);
+    }
+  }
+}
+
+double PathFollower::distanceTo(size_t segment, Vec position, double& t) {
+  Vec start = points[segment], delta = points[segment+1] - points[segment];
+  double len_sq = delta.x * delta.x + delta.y * delta.y;
+  Vec offset = position - start;
+  t = len_sq > 0 ? min(1.0, max(0.0, (offset.x * delta.x + offset.y * delta.y) / len_sq)) : 0;
+  return (position - (start + delta * t)).len();
+}
+
+bool PathFollower::searchBuckets(Vec position, size_t& best) {
+  int ci = static_cast<int>(floor((position.x - origin.x) / bucket_size));
+  int cj = static_cast<int>(floor((position.y - origin.y) / bucket_size));
+  double best_distance = INFINITY, t;
+  for (int j = max(0, cj - 1); j <= min(bucket_rows - 1, cj + 1); j++) {
+    for (int i = max(0, ci - 1); i <= min(bucket_cols - 1, ci + 1); i++) {
+      for (size_t k : buckets[j * bucket_cols + i]) {
+        if (k < index) continue;
+        searched++;
+        double distance = distanceTo(k, position, t);
+        if (distance < best_distance) {
+          best_distance = distance;
+          best = k;
+        }
+      }
+    }
+  }
+  return best_distance < INFINITY;
+}
+
+void PathFollower::update(Vec position) {
+  searched = 0;
+  if (points.size() < 2) return;
+  size_t segments = points.size() - 1;
+
+  // walk forward while the next segment is not farther, amortized O(1) per step
+  double t, best_t;
+  double best = distanceTo(index, position, best_t);
+  searched++;
+  while (index + 1 < segments) {
+    double next = distanceTo(index + 1, position, t);
+    searched++;
+    if (next > best) break;
+    index++;
+    best = next;
+    best_t = t;
+  }
+
+  // an overshoot can hide behind a local minimum, look a few segments further
+  double tolerance = bucket_size / 2;
+  if (best > tolerance) {
+    size_t found = index;
+    for (size_t k = index + 1; k < min(segments, index + 1 + SEARCH_WINDOW); k++) {
+      double distance = distanceTo(k, position, t);
+      searched++;
+      if (distance < best) {
+        best = distance;
+        found = k;
+      }
+    }
+    // still far off, the robot was pushed away, ask the buckets
+    size_t candidate = found;
+    if (best > tolerance && searchBuckets(position, candidate)) {
+      double distance = distanceTo(candidate, position, t);
+      if (distance < best) {
+        best = distance;
+        found = candidate;
+      }
+    }
+    index = found;
+    distanceTo(index, position, best_t);
+  }
+
+  Vec delta = points[index+1] - points[index];
+  progress = arcs.lengthAt(index) + (arcs.lengthAt(index+1) - arcs.lengthAt(index)) * best_t;
+  Vec offset = position - (Vec(points[index]) + delta * best_t);
+  double length = delta.len();
+  cross_track = length > 0 ? (delta.x * offset.y - delta.y * offset.x) / length : offset.len();
+}
+
+Vec PathFollower::getLookahead(double distance) {
+  // binary search over the cumulative lengths
+  return arcs.at(progress + distance);
+}
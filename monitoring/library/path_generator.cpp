@@ -1,15 +1,5 @@
 #include "path_generator.hpp"
 
-Node::Node(Vec coordinate, Node* parent) {
-    this->parent = parent;
-    this->coordinate = coordinate;
-    G = H = 0;
-}
-
-double Node::getScore(){
-    return G + H; 
-}
-
 double PathGenerator::getAstarLength() {
   double distance = 0;
   for (size_t i = 0; i < global->astar_path.size()-1; i++) {
@@ -19,293 +9,279 @@ double PathGenerator::getAstarLength() {
 }
 
 double PathGenerator::getBezierLength() {
-  double distance = 0;
-  for (size_t i = 0; i < global->bezier_path.size()-1; i++) {
-    distance += (global->bezier_path[i] - global->bezier_path[i+1]).len();
+  // rebuilt only after setBezierPath, every other call is the cached total
+  if (bezier_table_version != global->bezier_version) {
+    bezier_table.build(global->bezier_path);
+    bezier_table_version = global->bezier_version;
   }
-  return distance;
+  return bezier_table.getLength();
 }
 
 int PathGenerator::getTotalVisitedNode() {
-  return openList.size() + closeList.size();
+  // the start and every node the search opened
+  if (step_search) return step_stats.visited + 1;
+  return planned_nodes;
 }
 
-double PathGenerator::heuristic(Vec source, Vec target, int type) {
-    switch (type) {
-    case 1: // manhatan
-        return abs(target.x-source.x) + abs(target.y-source.y);
-        break;
-    case 2: // chebyshev
-        return max(abs(target.x-source.x), abs(target.y-source.y));
-        break;
-    case 3: // octile
-        return abs(target.x-source.x) + abs(target.y-source.y) +
-            (sqrt(2)-2) * min(abs(target.x-source.x), abs(target.y-source.y));
-        break;
-    case 4: // euclidean
-        return sqrt(pow(target.x-source.x, 2) + pow(target.y-source.y, 2));
-        break;
-    default:
-      cout << "false heuristic method" << endl;
-      return 0;
-    }
+void PathGenerator::updateObstacleGrid() {
+  if (shared_grid) {
+    obstacle_grid = shared_grid;
+    return;
+  }
+  // a fresh snapshot every time, queries may still hold the previous one
+  auto grid = make_shared<OccupancyGrid>(global->node_distance, global->screen_width, global->screen_height);
+  grid->build(global->obstacles);
+  obstacle_grid = grid;
 }
 
-bool PathGenerator::detectCollision(Vec pos) {
-    if (pos.x <= 0 || pos.x >= global->screen_width ||
-        pos.y <= 0 || pos.y >= global->screen_height) {
-        return true;
-    }
-    for (auto &item : global->obstacles) {
-        for (auto &obstacle : item) {
-            if (obstacle == pos) {
-                return true;
-            }
-        }
-    }
-    return false;
+PlanQuery PathGenerator::makeQuery(Vec start, const vector<Goal>& goals_) {
+  updateObstacleGrid();
+  PlanQuery query;
+  query.start = start;
+  query.goals = goals_;
+  query.grid = obstacle_grid;
+  query.params = makePlanParameters(global);
+  query.smooth = false;
+  return query;
 }
 
-vector<Vec> PathGenerator::getNeighbors(Vec pos, bool ignore_head) {
-  vector<Vec> directions = {
-      { 0, 1 }, { 1, 0 }, { 0, -1 }, { -1, 0 },
-      { -1, -1 }, { 1, 1 }, { -1, 1 }, { 1, -1 }
-  };
-  for (auto &item : directions) {
-      item = pos + item * global->node_distance;
+void PathGenerator::updateReachField() {
+  use_reach = global->reach_weight > 0;
+  if (!use_reach) return;
+  if (reach_grid.getNodeDistance() != global->node_distance ||
+      reach_grid.getCols() != static_cast<int>(global->screen_width / global->node_distance) + 1 ||
+      reach_grid.getRows() != static_cast<int>(global->screen_height / global->node_distance) + 1) {
+    reach_grid.resize(global->node_distance, global->screen_width, global->screen_height);
   }
-  if (ignore_head) return directions;
-  double temp_x = static_cast<int>(global->robot.x / global->node_distance) * global->node_distance;
-  double temp_y = static_cast<int>(global->robot.y / global->node_distance) * global->node_distance;
-  if (global->robot == Vec(temp_x, temp_y)) return directions;
-  vector<Vec> start_area {
-      Vec{temp_x, temp_y},
-      Vec{temp_x+global->node_distance, temp_y},
-      Vec{temp_x, temp_y+global->node_distance},
-      Vec{temp_x+global->node_distance, temp_y+global->node_distance},
-  };
-  temp_x = (int)(global->ball.x / global->node_distance) * global->node_distance;
-  temp_y = (int)(global->ball.y / global->node_distance) * global->node_distance;
-  vector<Vec> goal_area {
-      Vec{temp_x, temp_y},
-      Vec{temp_x+global->node_distance, temp_y},
-      Vec{temp_x, temp_y+global->node_distance},
-      Vec{temp_x+global->node_distance, temp_y+global->node_distance},
-  };
-  if (pos == global->robot) {
-      return start_area;
-  } else if (std::find(start_area.begin(), start_area.end(), pos) != start_area.end()) {
-      directions.push_back(global->robot);
-  } else if (std::find(goal_area.begin(), goal_area.end(), pos) != goal_area.end()) {
-      directions.push_back(global->ball);
-  }
-  return directions;
-    
+  reach.update(reach_grid, global->enemies, global->max_speed);
 }
 
-Node* PathGenerator::findNodeOnList(vector<Node*>& nodes, Vec coordinate) {
-    for (auto node : nodes) {
-        if (node->coordinate == coordinate) {
-            return node;
-        }
-    }
-    return nullptr;
+void PathGenerator::setSearch(Vec start, const vector<Goal>& goals_) {
+  // no reach times, the step mode shows the plain grid search
+  step_query = makeQuery(start, goals_);
+  step_stats = PlanStats();
+  step_search.reset(new GridSearch(step_query, step_scratch));
+  goal_index = -1;
 }
 
-void PathGenerator::releaseNodes(vector<Node*>& nodes) {
-    for (size_t i = 0; i < nodes.size(); i++) 
-        delete nodes[i];
-    nodes.clear();
+bool PathGenerator::stepSearch() {
+  if (!step_search) return true;
+  bool done = step_search->step(step_stats, &global->visited_node);
+  if (done) goal_index = step_search->getGoalIndex();
+  return done;
+}
+
+void PathGenerator::clearSearch() {
+  step_search.reset();
+}
+
+vector<SearchNode> PathGenerator::getSearchNodes() {
+  vector<SearchNode> nodes;
+  if (!step_search) return nodes;
+  for (size_t id = 0; id < step_search->getNodeCount(); id++) {
+    int state = step_search->getState(id);
+    if (state == NODE_NEW) continue;
+    int parent = step_search->getParent(id);
+    nodes.push_back(SearchNode{
+      step_search->getCoordinate(id), step_search->getG(id), step_search->getH(id),
+      state == NODE_CLOSED, parent >= 0, parent >= 0 ? step_search->getCoordinate(parent) : Vec()
+    });
+  }
+  return nodes;
 }
 
 void PathGenerator::generatePath() {
-  current = nullptr;
-  global->visited_node.clear();
-  
-  releaseNodes(openList);
-  releaseNodes(closeList);
+  generatePath(vector<Goal>{Goal{global->ball, 0}}, true);
+}
 
-  openList.clear();
-  closeList.clear();
+void PathGenerator::generatePath(const vector<Goal>& goals_, bool to_ball) {
+  updateReachField();
 
-  if ((global->robot - global->ball).len() < global->robot_radius) {
+  for (size_t i = 0; i < goals_.size(); i++) {
+    if ((global->robot - goals_[i].point).len() < global->robot_radius) {
+      goal_index = i;
+      global->astar_path = vector<Vec>{global->robot, to_ball ? global->ball : goals_[i].point};
+      global->normal_astar_path = global->astar_path;
+      return;
+    }
+  }
+
+  PlanQuery query = makeQuery(global->robot, goals_);
+  query.use_end = to_ball;
+  query.end = global->ball;
+  if (use_reach && !reach.empty()) query.reach_times = make_shared<const vector<double>>(reach.getDominance());
+
+  PlanResult result = Planner::plan(query);
+  planned_nodes = result.stats.visited + 1;
+  if (!result.found) {
+    global->visited_node.clear();
     global->astar_path = vector<Vec>{global->robot, global->ball};
+    global->normal_astar_path = global->astar_path;
     return;
   }
+  goal_index = result.goal_index;
+  global->visited_node = result.visited;
+  global->astar_path = result.path;
+  global->normal_astar_path = result.path;
+  modified_path();
+}
+
+PathGenerator::ReplanResult PathGenerator::replanLocal(int& path_index) {
+  vector<Vec> &path = global->normal_astar_path;
+  if (path.size() < 4 || global->bezier_path.empty()) return REPLAN_FULL;
+  updateObstacleGrid();
 
-  bool isFound = false;
-  openList.push_back(new Node(global->robot));
-  while (!openList.empty()) {
-    if (astar_find_next_node()) {
-      isFound = true;
+  // only the part of the path ahead of the robot matters
+  size_t nearest = 1;
+  for (size_t i = 1; i < path.size()-1; i++) {
+    if ((path[i] - global->robot).len() < (path[nearest] - global->robot).len()) nearest = i;
+  }
+  size_t invalid = 0;
+  for (size_t i = nearest; i < path.size()-1; i++) {
+    if (obstacle_grid->blocked(path[i])) {
+      invalid = i;
       break;
     }
-    astar_find_neighbors();
   }
+  if (invalid == 0) return REPLAN_NONE;
 
-  if (!isFound) {
-    global->visited_node.clear();
-    global->astar_path = vector<Vec>{global->robot, global->ball};
-    return;
+  // rejoin one node past the blocked run, on the untouched remainder
+  size_t rejoin = invalid;
+  while (rejoin < path.size()-1 && obstacle_grid->blocked(path[rejoin])) rejoin++;
+  rejoin++;
+  if (rejoin >= path.size()-1) return REPLAN_FULL;
+
+  Vec window_min = global->robot, window_max = global->robot;
+  for (size_t i = nearest; i <= rejoin; i++) {
+    window_min = Vec(min(window_min.x, path[i].x), min(window_min.y, path[i].y));
+    window_max = Vec(max(window_max.x, path[i].x), max(window_max.y, path[i].y));
   }
+  Vec margin = Vec(1, 1) * (global->replan_window * global->node_distance);
+  window_min = window_min - margin;
+  window_max = window_max + margin;
 
-  process_path();
-  modified_path();
-}
+  PlanQuery query = makeQuery(global->robot, vector<Goal>{Goal{path[rejoin], 0}});
+  query.use_window = true;
+  query.window_min = window_min;
+  query.window_max = window_max;
+  PlanResult result = Planner::plan(query);
+  planned_nodes = result.stats.visited + 1;
+  global->visited_node = result.visited;
+  if (!result.found) return REPLAN_FULL;
 
-bool PathGenerator::astar_find_next_node() {
-  auto current_it = openList.begin();
-  current = *current_it;
-  for (auto it = openList.begin(); it != openList.end(); it++) {
-      auto node = *it;
-      if (node->getScore() < current->getScore()) {
-          current = node;
-          current_it = it;
-      }
+  vector<Vec> local = result.nodes;
+  local.insert(local.begin(), global->robot);
+
+  // the smoothed remainder starts at the sample closest to the rejoin node
+  size_t join = path_index < 0 ? 0 : path_index;
+  for (size_t i = join; i < global->bezier_path.size(); i++) {
+    if ((global->bezier_path[i] - path[rejoin]).len() < (global->bezier_path[join] - path[rejoin]).len()) join = i;
+  }
+
+  vector<Vec> control;
+  for (size_t i = 0; i < local.size(); i++) {
+    bool turn = i > 0 && i+1 < local.size() &&
+      !(local[i] - local[i-1] == local[i+1] - local[i]);
+    for (int j = 0; j < (turn ? global->bezier_curvature : 1); j++) control.push_back(local[i]);
   }
-  closeList.push_back(current);
-  openList.erase(current_it);
+  control.push_back(global->bezier_path[join]);
+  double local_length = 0;
+  for (size_t i = 1; i < control.size(); i++) local_length += (control[i] - control[i-1]).len();
+
+  int numPoints = max(2, static_cast<int>(local_length / 10));
+  vector<Vec> smooth = smoothCurve(control, numPoints);
+  smooth.insert(smooth.end(), global->bezier_path.begin() + join + 1, global->bezier_path.end());
+  global->setBezierPath(smooth);
+
+  // local already starts at the robot
+  vector<Vec> stitched = local;
+  stitched.insert(stitched.end(), path.begin() + rejoin + 1, path.end());
+  global->normal_astar_path = stitched;
+  global->astar_path = stitched;
+  modified_path();
 
-  if (current->coordinate == global->ball) return true;
-  return false;
+  path_index = 0;
+  return REPLAN_LOCAL;
 }
 
-void PathGenerator::astar_find_neighbors(bool ignore_head) {
-  for (auto &neighbor : getNeighbors(current->coordinate, ignore_head)) {
-      if (detectCollision(neighbor) || findNodeOnList(closeList, neighbor)) continue;
-      int totalCost = current->G + (current->coordinate - neighbor).len();
-
-      Node* successor = findNodeOnList(openList, neighbor);
-      if (successor == nullptr) {
-          successor = new Node(neighbor, current);
-          successor->G = totalCost;
-          successor->H = heuristic(successor->coordinate, global->ball, global->heuristic_type);
-          openList.push_back(successor);
-          global->visited_node.push_back(neighbor);
-      } else if (totalCost < successor->G) {
-          successor->parent = current;
-          successor->G = totalCost;
-      }
-  }
+void PathGenerator::generateApproachPath() {
+  vector<Goal> approach = getApproachGoals();
+  if (approach.empty()) generatePath();
+  else generatePath(approach, true);
 }
 
-void PathGenerator::process_path() {
-  vector<Vec> path;
-  path.push_back(global->ball);
-  while(current != nullptr) {
-      path.push_back(current->coordinate);
-      current = current->parent;
+vector<Goal> PathGenerator::getApproachGoals() {
+  // kick positions behind the ball, cheaper the better they line up with the opponent goal
+  vector<Goal> result;
+  if (global->approach_goals <= 0) return result;
+  updateObstacleGrid();
+  Vec behind = global->ball - global->opponent_goal;
+  double base = atan2(behind.y, behind.x);
+  double spread = M_PI / 2;
+  for (int k = 0; k < global->approach_goals; k++) {
+    double offset = global->approach_goals == 1 ? 0 : -spread + 2 * spread * k / (global->approach_goals - 1);
+    Vec point = global->ball + Vec(cos(base + offset), sin(base + offset)) * global->robot_radius;
+    Vec cell(
+      round(point.x / global->node_distance) * global->node_distance,
+      round(point.y / global->node_distance) * global->node_distance);
+    if (obstacle_grid->blocked(cell)) continue;
+    bool duplicate = false;
+    for (auto &goal : result) duplicate = duplicate || goal.point == cell;
+    if (duplicate) continue;
+    result.push_back(Goal{cell, global->approach_weight * abs(offset) * global->robot_radius});
   }
-  path.push_back(global->robot);
-  reverse(path.begin(), path.end());
-
-  global->astar_path = path;
-  // temp
-  global->normal_astar_path = path;
+  return result;
 }
 
 void PathGenerator::modified_path(bool ignore_head) {
-  if (!ignore_head && global->astar_path.size() < 5) return;
-  if (ignore_head && global->astar_path.size() < 3) return;
-
-  auto get_dir_func = [](Vec point1, Vec point2) {
-    Vec delta = point1-point2;
-    if (delta.x > 0 && delta.y == 0) return 1;
-    if (delta.x > 0 && delta.y > 0) return 2;
-    if (delta.x > 0 && delta.y < 0) return 3;
-    if (delta.x < 0 && delta.y == 0) return 4;
-    if (delta.x < 0 && delta.y > 0) return 5;
-    if (delta.x < 0 && delta.y < 0) return 6;
-    if (delta.x == 0 && delta.y > 0) return 7;
-    if (delta.x == 0 && delta.y < 0)return 8;
-    return -1;
-  };
-
-  vector<Vec> filter_path;
-  filter_path.push_back(global->astar_path[0]);
-  size_t start_index;
-  if (!ignore_head) {
-    start_index = 2;
-    filter_path.push_back(global->astar_path[1]);
-  } else {
-    start_index = 1;
-  }
-  size_t i = start_index;
-  int dir = get_dir_func(global->astar_path[start_index-1], global->astar_path[start_index]);
-  while (i != global->astar_path.size()-start_index) {
-    int new_dir = get_dir_func(global->astar_path[i], global->astar_path[i+1]);
-    if (dir != new_dir) {
-      for (int j = 0; j < global->bezier_curvature; j++) filter_path.push_back(global->astar_path[i]);
-      dir = new_dir;
-    } else {
-      filter_path.push_back(global->astar_path[i]);
-    }
-    i++;
-  }
-  if (!ignore_head) {
-    filter_path.push_back(global->astar_path[global->astar_path.size()-2]);
-  }
-  filter_path.push_back(global->astar_path[global->astar_path.size()-1]);
+  vector<Vec> padded = Planner::padCorners(global->astar_path, global->bezier_curvature, ignore_head);
+  if (!ignore_head) global->astar_path = padded;
+  else global->modified_astar_path = padded;
+}
 
-  if (!ignore_head) global->astar_path = filter_path;
-  else global->modified_astar_path = filter_path;
+vector<Vec> PathGenerator::smoothCurve(const vector<Vec>& control, int numPoints) {
+    updateObstacleGrid();
+    return Planner::smoothCurve(control, makePlanParameters(global), *obstacle_grid, numPoints);
 }
 
 void PathGenerator::generateSmoothPath(int numPoints) {
-    vector<Vec> result(numPoints+1);
-    vector<Vec> temp_result(numPoints+1);
-    for (int i = 0; i <= numPoints; ++i) {
-        double t = static_cast<double>(i) / numPoints;
-        vector<Vec> points;
-        for (Vec point : global->astar_path) {
-            points.push_back(point);
-        }
-        int n = points.size();
-
-        for (int j = 1; j < n; ++j) {
-            for (int k = 0; k < n - j; ++k) {
-                points[k] = points[k]*(1 - t) + points[k + 1]*t;
-            }
-        }
-        result[i] = points[0];
-        points.clear();
-        for (Vec point : global->normal_astar_path) {
-            points.push_back(point);
-        }
-        n = points.size();
-
-        for (int j = 1; j < n; ++j) {
-            for (int k = 0; k < n - j; ++k) {
-                points[k] = points[k]*(1 - t) + points[k + 1]*t;
-            }
-        }
-        temp_result[i] = points[0];
+    updateObstacleGrid();
+    PlanParameters params = makePlanParameters(global);
+    // the same curve a plan smooths, astar_path holds these nodes already padded
+    global->setBezierPath(Planner::smoothPath(global->normal_astar_path, params, *obstacle_grid, numPoints));
+    // the Bezier without the padding, only drawn to compare against
+    if (global->smooth_type == 0) {
+        global->normal_bezier_path = Planner::smoothCurve(global->normal_astar_path, params, *obstacle_grid, numPoints);
+    } else {
+        global->normal_bezier_path.clear();
     }
-    global->bezier_path = result;
-    global->normal_bezier_path = temp_result;
 }
 
 void PathGenerator::getBezierPoints(int numPoints, int index) {
-  vector<Vec> result(index+1);
-  vector<vector<Vec>> control_points;
-  for (int i = 0; i <= index; ++i) {
-      double t = static_cast<double>(i) / numPoints;
-      vector<Vec> points;
-      for (Vec point : global->modified_astar_path) {
-          points.push_back(point);
-      }
-      int n = points.size();
-      
-      for (int j = 1; j < n; ++j) {
-        vector<Vec> temp;
-        for (int k = 0; k < n - j; ++k) {
-            points[k] = points[k]*(1 - t) + points[k + 1]*t;
-            temp.push_back(points[k]);
-        }
-        control_points.push_back(temp);
-      }
-      result[i] = points[0];
+  vector<Vec> &control = global->modified_astar_path;
+  // the sampled curve only changes with the control polygon, not with the slider
+  bool same = slider_samples == numPoints && slider_control.size() == control.size();
+  for (size_t i = 0; same && i < control.size(); i++) same = slider_control[i] == control[i];
+  if (!same) {
+    slider_control = control;
+    slider_samples = numPoints;
+    evaluator.evaluate(control, numPoints, slider_curve);
+  }
+  if (slider_curve.empty()) return;
+  index = max(0, min(index, numPoints));
+  global->setBezierPath(vector<Vec>(slider_curve.begin(), slider_curve.begin() + index + 1));
+
+  // intermediate polygons of the current t only, reusing the previous levels
+  double t = static_cast<double>(index) / numPoints;
+  int n = control.size();
+  vector<vector<Vec>> &levels = global->control_points;
+  levels.resize(max(n - 1, 0));
+  for (int j = 1; j < n; ++j) {
+    vector<Vec> &previous = j == 1 ? control : levels[j-2];
+    vector<Vec> &level = levels[j-1];
+    level.resize(n - j);
+    for (int k = 0; k < n - j; ++k) {
+      level[k] = previous[k]*(1 - t) + previous[k + 1]*t;
+    }
   }
-  global->bezier_path = result;
-  global->control_points = control_points;
-}
\ No newline at end of file
+}
@@ -0,0 +1,151 @@
+#include "path_validator.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VALIDATOR_X86
+#endif
+
+const size_t SEGMENT_BLOCK = 4;
+// padding segments sit far outside the field so they never hit an enemy
+const double FAR_AWAY = 1e12;
+
+struct SegmentArrays {
+  const double *sx, *sy, *dx, *dy, *inv;
+};
+
+typedef int (*CircleKernel)(const SegmentArrays&, size_t from, size_t to,
+                            const double* cx, const double* cy, size_t enemies, double radius_sq);
+
+// first segment in [from, to) closer than the radius to any enemy, the vector kernels read up to
+// one block past to
+static int circleScalar(const SegmentArrays& s, size_t from, size_t to,
+                        const double* cx, const double* cy, size_t enemies, double radius_sq) {
+  for (size_t k = from; k < to; k++) {
+    for (size_t e = 0; e < enemies; e++) {
+      double t = ((cx[e] - s.sx[k]) * s.dx[k] + (cy[e] - s.sy[k]) * s.dy[k]) * s.inv[k];
+      t = min(1.0, max(0.0, t));
+      double ex = s.sx[k] + s.dx[k] * t - cx[e], ey = s.sy[k] + s.dy[k] * t - cy[e];
+      if (ex * ex + ey * ey < radius_sq) return k;
+    }
+  }
+  return -1;
+}
+
+#ifdef VALIDATOR_X86
+static int circleSse(const SegmentArrays& s, size_t from, size_t to,
+                     const double* cx, const double* cy, size_t enemies, double radius_sq) {
+  const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1.0), r2 = _mm_set1_pd(radius_sq);
+  for (size_t k = from; k < to; k += 2) {
+    __m128d sx = _mm_loadu_pd(s.sx + k), sy = _mm_loadu_pd(s.sy + k);
+    __m128d dx = _mm_loadu_pd(s.dx + k), dy = _mm_loadu_pd(s.dy + k);
+    __m128d inv = _mm_loadu_pd(s.inv + k);
+    int mask = 0;
+    for (size_t e = 0; e < enemies; e++) {
+      __m128d ox = _mm_sub_pd(_mm_set1_pd(cx[e]), sx), oy = _mm_sub_pd(_mm_set1_pd(cy[e]), sy);
+      __m128d t = _mm_mul_pd(_mm_add_pd(_mm_mul_pd(ox, dx), _mm_mul_pd(oy, dy)), inv);
+      t = _mm_min_pd(one, _mm_max_pd(zero, t));
+      __m128d ex = _mm_sub_pd(_mm_mul_pd(dx, t), ox), ey = _mm_sub_pd(_mm_mul_pd(dy, t), oy);
+      __m128d d2 = _mm_add_pd(_mm_mul_pd(ex, ex), _mm_mul_pd(ey, ey));
+      mask |= _mm_movemask_pd(_mm_cmplt_pd(d2, r2));
+    }
+    if (mask) return k + __builtin_ctz(mask);
+  }
+  return -1;
+}
+
+__attribute__((target("avx2,fma")))
+static int circleAvx2(const SegmentArrays& s, size_t from, size_t to,
+                      const double* cx, const double* cy, size_t enemies, double radius_sq) {
+  const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0), r2 = _mm256_set1_pd(radius_sq);
+  for (size_t k = from; k < to; k += SEGMENT_BLOCK) {
+    __m256d sx = _mm256_loadu_pd(s.sx + k), sy = _mm256_loadu_pd(s.sy + k);
+    __m256d dx = _mm256_loadu_pd(s.dx + k), dy = _mm256_loadu_pd(s.dy + k);
+    __m256d inv = _mm256_loadu_pd(s.inv + k);
+    int mask = 0;
+    for (size_t e = 0; e < enemies; e++) {
+      __m256d ox = _mm256_sub_pd(_mm256_set1_pd(cx[e]), sx), oy = _mm256_sub_pd(_mm256_set1_pd(cy[e]), sy);
+      __m256d t = _mm256_mul_pd(_mm256_fmadd_pd(ox, dx, _mm256_mul_pd(oy, dy)), inv);
+      t = _mm256_min_pd(one, _mm256_max_pd(zero, t));
+      __m256d ex = _mm256_fmsub_pd(dx, t, ox), ey = _mm256_fmsub_pd(dy, t, oy);
+      __m256d d2 = _mm256_fmadd_pd(ex, ex, _mm256_mul_pd(ey, ey));
+      mask |= _mm256_movemask_pd(_mm256_cmp_pd(d2, r2, _CMP_LT_OQ));
+    }
+    if (mask) return k + __builtin_ctz(mask);
+  }
+  return -1;
+}
+#endif
+
+static CircleKernel selectKernel(const char** name) {
+#ifdef VALIDATOR_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    *name = "avx2";
+    return circleAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    *name = "sse2";
+    return circleSse;
+  }
+#endif
+  *name = "scalar";
+  return circleScalar;
+}
+
+static const char* kernel_name = "scalar";
+static CircleKernel circle_kernel = selectKernel(&kernel_name);
+
+// PathValidator implementation
+const char* PathValidator::getKernelName() {
+  return kernel_name;
+}
+
+void PathValidator::setPath(const vector<Vec>& path) {
+  // rebuilt every time, a replan can keep the sample count and both ends
+  points = path;
+  size_t segments = points.size() > 1 ? points.size() - 1 : 0;
+  size_t padded = (segments + SEGMENT_BLOCK - 1) / SEGMENT_BLOCK * SEGMENT_BLOCK + SEGMENT_BLOCK;
+  start_x.assign(padded, FAR_AWAY);
+  start_y.assign(padded, FAR_AWAY);
+  delta_x.assign(padded, 0.0);
+  delta_y.assign(padded, 0.0);
+  inv_len_sq.assign(padded, 0.0);
+  for (size_t k = 0; k < segments; k++) {
+    start_x[k] = points[k].x;
+    start_y[k] = points[k].y;
+    delta_x[k] = points[k+1].x - points[k].x;
+    delta_y[k] = points[k+1].y - points[k].y;
+    double len_sq = delta_x[k] * delta_x[k] + delta_y[k] * delta_y[k];
+    inv_len_sq[k] = len_sq > 1e-12 ? 1 / len_sq : 0;
+  }
+}
+
+void PathValidator::setEnemies(const vector<Vec>& enemies, double radius) {
+  enemy_x.resize(enemies.size());
+  enemy_y.resize(enemies.size());
+  for (size_t e = 0; e < enemies.size(); e++) {
+    enemy_x[e] = enemies[e].x;
+    enemy_y[e] = enemies[e].y;
+  }
+  radius_sq = radius * radius;
+}
+
+int PathValidator::firstInvalid(size_t from, const OccupancyGrid* grid) {
+  if (points.size() < 2 || from >= points.size() - 1) return -1;
+  size_t segments = points.size() - 1;
+
+  int hit = -1;
+  if (!enemy_x.empty()) {
+    // the arrays carry a spare block, so the unaligned loads from any start stay inside
+    SegmentArrays arrays{start_x.data(), start_y.data(), delta_x.data(), delta_y.data(), inv_len_sq.data()};
+    hit = circle_kernel(arrays, from, segments, enemy_x.data(), enemy_y.data(), enemy_x.size(), radius_sq);
+  }
+  if (grid == nullptr) return hit;
+
+  // the grid only needs walking up to the first circle hit, the end squares belong to the robot and the goal
+  size_t last = hit >= 0 ? hit : segments;
+  for (size_t k = from; k < last; k++) {
+    if (!grid->segmentClear(points[k], points[k+1], k > from, k + 1 < segments)) return k;
+  }
+  return hit;
+}
@@ -0,0 +1,110 @@
+#include "plan_worker.hpp"
+#include "tracker.hpp"
+
+PlanWorker::PlanWorker(const GlobalData& global_): global(global_), generator(&global) {
+  // the caller keeps updating its tracker, this thread must not share it
+  global.tracker = make_shared<EnemyTracker>();
+  worker = thread(&PlanWorker::loop, this);
+}
+
+PlanWorker::~PlanWorker() {
+  {
+    lock_guard<mutex> lock(queue_mutex);
+    stopping = true;
+  }
+  queue_cv.notify_one();
+  worker.join();
+}
+
+unsigned int PlanWorker::submit(PlanRequest request) {
+  unsigned int id;
+  {
+    lock_guard<mutex> lock(queue_mutex);
+    // every request carries a whole world version, the older one is superseded
+    if (has_pending) dropped++;
+    pending = move(request);
+    pending_id = id = ++next_id;
+    pending_time = chrono::steady_clock::now();
+    has_pending = true;
+  }
+  queue_cv.notify_one();
+  return id;
+}
+
+void PlanWorker::loop() {
+  while (true) {
+    PlanRequest request;
+    auto back = make_shared<PlanSnapshot>();
+    {
+      unique_lock<mutex> lock(queue_mutex);
+      queue_cv.wait(lock, [this]() { return has_pending || stopping; });
+      if (stopping) return;
+      request = move(pending);
+      back->id = pending_id;
+      back->submitted = pending_time;
+      has_pending = false;
+      busy = true;
+    }
+    back->generation = request.generation;
+    back->world_version = request.world->version;
+    back->reason = request.reason;
+
+    auto start = chrono::steady_clock::now();
+    back->queue_us = chrono::duration<double, micro>(start - back->submitted).count();
+    plan(request, *back);
+    back->plan_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    encode(*back);
+    back->published = chrono::steady_clock::now();
+
+    atomic_store(&published, shared_ptr<const PlanSnapshot>(back));
+    completed++;
+    busy = false;
+  }
+}
+
+void PlanWorker::plan(const PlanRequest& request, PlanSnapshot& result) {
+  const WorldSnapshot &world = *request.world;
+  global.robot = world.robot;
+  global.ball = world.ball;
+  global.enemies = *world.enemies;
+  global.obstacles = *world.obstacles;
+  // the world's grid already matches its obstacles
+  generator.setObstacleGrid(world.grid);
+
+  bool repaired = false;
+  if (request.local && request.base) {
+    global.normal_astar_path = request.base->normal_astar_path;
+    global.astar_path = request.base->astar_path;
+    global.setBezierPath(request.base->bezier_path);
+    int path_index = request.path_index;
+    repaired = generator.replanLocal(path_index) == PathGenerator::REPLAN_LOCAL;
+  }
+  if (!repaired) {
+    // a clear grid path can still have an invalid smoothing, start over then
+    generator.generateApproachPath();
+    generator.generateSmoothPath(generator.getAstarLength()/10);
+  }
+  result.local = repaired;
+  result.astar_path = global.astar_path;
+  result.normal_astar_path = global.normal_astar_path;
+  result.bezier_path = global.bezier_path;
+  result.astar_length = generator.getAstarLength();
+}
+
+void PlanWorker::encode(PlanSnapshot& result) {
+  auto elapsed = [](chrono::steady_clock::time_point since) {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - since).count();
+  };
+  auto start = chrono::steady_clock::now();
+  result.astar_message = pathJson("astar_path", result.astar_path);
+  result.astar_json_us = elapsed(start);
+  start = chrono::steady_clock::now();
+  result.bezier_message = pathJson("bezier_path", result.bezier_path);
+  result.bezier_json_us = elapsed(start);
+  start = chrono::steady_clock::now();
+  result.astar_frame = encodePath(FRAME_ASTAR_PATH, result.astar_path);
+  result.astar_frame_us = elapsed(start);
+  start = chrono::steady_clock::now();
+  result.bezier_frame = encodePath(FRAME_BEZIER_PATH, result.bezier_path);
+  result.bezier_frame_us = elapsed(start);
+}
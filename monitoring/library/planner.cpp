@@ -0,0 +1,362 @@
+#include "planner.hpp"
+#include "bezier.hpp"
+#include "spline.hpp"
+#include "arc_length.hpp"
+#include "fillet.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+void SearchScratch::reset(size_t nodes) {
+  G.assign(nodes, 0);
+  H.assign(nodes, 0);
+  length.assign(nodes, 0);
+  parent.assign(nodes, -1);
+  order.assign(nodes, 0);
+  state.assign(nodes, 0);
+  coordinate.resize(nodes);
+  heap.clear();
+}
+
+// per thread, sized to the largest query this thread has seen
+static thread_local SearchScratch scratch;
+
+static double elapsedUs(chrono::steady_clock::time_point since) {
+  return chrono::duration<double, micro>(chrono::steady_clock::now() - since).count();
+}
+
+PlanParameters makePlanParameters(GlobalData* global) {
+  PlanParameters params;
+  params.node_distance = global->node_distance;
+  params.screen_width = global->screen_width;
+  params.screen_height = global->screen_height;
+  params.heuristic_type = global->heuristic_type;
+  params.smooth_type = global->smooth_type;
+  params.bezier_curvature = global->bezier_curvature;
+  params.path_spacing = global->path_spacing;
+  params.flatness_tolerance = global->flatness_tolerance;
+  params.min_turn_radius = global->min_turn_radius;
+  params.reach_weight = global->reach_weight;
+  params.max_speed = global->max_speed;
+  return params;
+}
+
+double Planner::heuristic(Vec source, Vec target, int type) {
+  switch (type) {
+    case 1: // manhatan
+      return abs(target.x-source.x) + abs(target.y-source.y);
+    case 2: // chebyshev
+      return max(abs(target.x-source.x), abs(target.y-source.y));
+    case 3: // octile
+      return abs(target.x-source.x) + abs(target.y-source.y) +
+        (sqrt(2)-2) * min(abs(target.x-source.x), abs(target.y-source.y));
+    case 4: // euclidean
+      return sqrt(pow(target.x-source.x, 2) + pow(target.y-source.y, 2));
+    default:
+      cout << "false heuristic method" << endl;
+      return 0;
+  }
+}
+
+// GridSearch implementation
+GridSearch::GridSearch(const PlanQuery& query_, SearchScratch& s_): query(query_), params(query_.params), s(s_) {
+  const OccupancyGrid &grid = *query.grid;
+  nd = params.node_distance;
+  cols = grid.getCols();
+  cells = grid.getSize();
+  start_id = cells;
+  s.reset(cells + 1 + query.goals.size());
+  for (size_t id = 0; id < cells; id++) s.coordinate[id] = grid.toPoint(id % cols, id / cols);
+
+  // off-grid start and goals get their own node, on-grid ones are the cell
+  start_area = area(query.start);
+  start_on_grid = query.start == grid.toPoint(start_area.first, start_area.second);
+  if (start_on_grid) start_id = cellId(start_area.first, start_area.second);
+  s.coordinate[cells] = query.start;
+  for (size_t k = 0; k < query.goals.size(); k++) {
+    Vec point = query.goals[k].point;
+    pair<int, int> cell = area(point);
+    int id = cells + 1 + k;
+    bool on_grid = point == grid.toPoint(cell.first, cell.second);
+    if (on_grid) id = cellId(cell.first, cell.second);
+    s.coordinate[cells + 1 + k] = point;
+    goal_ids.push_back(id);
+    if (!on_grid) goal_areas.push_back({cell, id});
+  }
+  if (start_id >= 0) open(start_id, -1, 0, 0);
+  else done = true;
+}
+
+bool GridSearch::step(PlanStats& stats, vector<Vec>* visited) {
+  if (done) return true;
+  int id = pop();
+  if (id < 0) return done = true;
+  double score = s.G[id] + s.H[id];
+  // no open node can beat the best goal reached so far
+  if (best >= 0 && best_cost <= score) return done = true;
+  s.state[id] = NODE_CLOSED;
+  stats.expanded++;
+
+  int index = findGoal(id);
+  if (index >= 0 && (best < 0 || s.G[id] + query.goals[index].cost < best_cost)) {
+    best = id;
+    best_cost = s.G[id] + query.goals[index].cost;
+    goal_index = index;
+  }
+  if (best >= 0 && best_cost <= score) return done = true;
+  expand(id, stats, visited);
+  return false;
+}
+
+int GridSearch::run(PlanStats& stats, vector<Vec>* visited) {
+  while (!step(stats, visited));
+  return best;
+}
+
+vector<Vec> GridSearch::nodesTo(int id) const {
+  vector<Vec> nodes;
+  for (; id >= 0; id = s.parent[id]) nodes.push_back(s.coordinate[id]);
+  reverse(nodes.begin(), nodes.end());
+  return nodes;
+}
+
+pair<int, int> GridSearch::area(Vec point) const {
+  return { static_cast<int>(point.x / nd), static_cast<int>(point.y / nd) };
+}
+
+int GridSearch::cellId(int i, int j) const {
+  return query.grid->inside(i, j) ? static_cast<int>(query.grid->index(i, j)) : -1;
+}
+
+bool GridSearch::inArea(pair<int, int> base, int i, int j) {
+  return (i == base.first || i == base.first + 1) && (j == base.second || j == base.second + 1);
+}
+
+int GridSearch::findGoal(int id) const {
+  for (size_t k = 0; k < goal_ids.size(); k++) {
+    if (goal_ids[k] == id) return k;
+  }
+  return -1;
+}
+
+double GridSearch::goalHeuristic(Vec pos) const {
+  // admissible for the cheapest goal: min over goals of distance plus terminal cost
+  double result = -1;
+  for (auto &goal : query.goals) {
+    double value = Planner::heuristic(pos, goal.point, params.heuristic_type) + goal.cost;
+    if (result < 0 || value < result) result = value;
+  }
+  return result < 0 ? 0 : result;
+}
+
+bool GridSearch::blocked(int id) const {
+  Vec pos = s.coordinate[id];
+  if (pos.x <= 0 || pos.x >= params.screen_width || pos.y <= 0 || pos.y >= params.screen_height) return true;
+  if (query.use_window && (pos.x < query.window_min.x || pos.x > query.window_max.x ||
+      pos.y < query.window_min.y || pos.y > query.window_max.y)) {
+    return true;
+  }
+  if (static_cast<size_t>(id) < cells) {
+    int i = id % cols, j = id / cols;
+    return query.grid->blocked(i, j);
+  }
+  return false;
+}
+
+double GridSearch::reachCost(Vec pos, double length) const {
+  // penalize cells an enemy reaches before the robot does
+  if (!query.reach_times || params.reach_weight <= 0) return 0;
+  int i, j;
+  query.grid->toCell(pos, i, j);
+  if (!query.grid->inside(i, j)) return 0;
+  size_t cell = query.grid->index(i, j);
+  if (cell >= query.reach_times->size()) return 0;
+  double robot_time = length / params.max_speed;
+  double enemy_time = (*query.reach_times)[cell];
+  if (enemy_time >= robot_time) return 0;
+  return params.reach_weight * (robot_time - enemy_time) * params.max_speed;
+}
+
+// ties go to the node opened first, like the first match of a linear scan
+static bool later(const SearchScratch::Entry& a, const SearchScratch::Entry& b) {
+  return a.score > b.score || (a.score == b.score && a.order > b.order);
+}
+
+void GridSearch::push(int id) {
+  s.heap.push_back({s.G[id] + s.H[id], s.order[id], id, s.G[id]});
+  push_heap(s.heap.begin(), s.heap.end(), later);
+}
+
+int GridSearch::pop() {
+  while (!s.heap.empty()) {
+    SearchScratch::Entry entry = s.heap.front();
+    pop_heap(s.heap.begin(), s.heap.end(), later);
+    s.heap.pop_back();
+    // lowered nodes leave their old entry behind
+    if (s.state[entry.id] == NODE_OPEN && entry.G == s.G[entry.id]) return entry.id;
+  }
+  return -1;
+}
+
+void GridSearch::open(int id, int parent, double G, double length) {
+  s.state[id] = NODE_OPEN;
+  s.parent[id] = parent;
+  s.G[id] = G;
+  s.length[id] = length;
+  s.H[id] = goalHeuristic(s.coordinate[id]);
+  s.order[id] = inserted++;
+  push(id);
+}
+
+void GridSearch::relax(int from, int id, PlanStats& stats, vector<Vec>* visited) {
+  if (id < 0 || s.state[id] == NODE_CLOSED || blocked(id)) return;
+  double edge = (s.coordinate[from] - s.coordinate[id]).len();
+  double length = s.length[from] + edge;
+  double totalCost = s.G[from] + edge + reachCost(s.coordinate[id], length);
+  if (s.state[id] == NODE_NEW) {
+    open(id, from, totalCost, length);
+    stats.visited++;
+    if (visited != nullptr) visited->push_back(s.coordinate[id]);
+  } else if (totalCost < s.G[id]) {
+    s.parent[id] = from;
+    s.G[id] = totalCost;
+    s.length[id] = length;
+    push(id);
+  }
+}
+
+void GridSearch::expand(int id, PlanStats& stats, vector<Vec>* visited) {
+  const int di[8] = { 0, 1, 0, -1, -1, 1, -1, 1 };
+  const int dj[8] = { 1, 0, -1, 0, -1, 1, 1, -1 };
+  if (!start_on_grid && id == static_cast<int>(cells)) {
+    // off-grid start connects to the four nodes around it
+    relax(id, cellId(start_area.first, start_area.second), stats, visited);
+    relax(id, cellId(start_area.first+1, start_area.second), stats, visited);
+    relax(id, cellId(start_area.first, start_area.second+1), stats, visited);
+    relax(id, cellId(start_area.first+1, start_area.second+1), stats, visited);
+    return;
+  }
+  // off-grid goals are terminal
+  if (static_cast<size_t>(id) >= cells) return;
+
+  int i = id % cols, j = id / cols;
+  for (int k = 0; k < 8; k++) relax(id, cellId(i + di[k], j + dj[k]), stats, visited);
+  if (!start_on_grid && inArea(start_area, i, j)) {
+    relax(id, cells, stats, visited);
+    return;
+  }
+  for (auto &item : goal_areas) {
+    if (inArea(item.first, i, j)) relax(id, item.second, stats, visited);
+  }
+}
+
+PlanResult Planner::plan(const PlanQuery& query) {
+  PlanResult result;
+  if (!query.grid) return result;
+  auto begin = chrono::steady_clock::now();
+
+  GridSearch search(query, scratch);
+  int goal = search.run(result.stats, &result.visited);
+  result.stats.search_us = elapsedUs(begin);
+  if (goal < 0) return result;
+
+  result.found = true;
+  result.goal_index = search.getGoalIndex();
+  result.nodes = search.nodesTo(goal);
+
+  result.path.push_back(query.start);
+  result.path.insert(result.path.end(), result.nodes.begin(), result.nodes.end());
+  result.path.push_back(query.use_end ? query.end : query.goals[result.goal_index].point);
+
+  if (query.smooth) {
+    begin = chrono::steady_clock::now();
+    int numPoints = query.smooth_points;
+    if (numPoints <= 0) {
+      double length = 0;
+      for (size_t i = 1; i < result.path.size(); i++) length += (result.path[i] - result.path[i-1]).len();
+      numPoints = max(2, static_cast<int>(length / 10));
+    }
+    result.smooth_path = smoothPath(result.path, query.params, *query.grid, numPoints);
+    result.stats.smooth_us = elapsedUs(begin);
+  }
+  return result;
+}
+
+vector<Vec> Planner::smoothPath(const vector<Vec>& path, const PlanParameters& params,
+                                const OccupancyGrid& grid, int numPoints) {
+  // b-splines and fillets run over the raw nodes, the plain Bezier needs the corners padded
+  if (params.smooth_type != 0) return smoothCurve(path, params, grid, numPoints);
+  return smoothCurve(padCorners(path, params.bezier_curvature), params, grid, numPoints);
+}
+
+vector<Vec> Planner::smoothCurve(const vector<Vec>& control, const PlanParameters& params,
+                                 const OccupancyGrid& grid, int numPoints) {
+  if (params.smooth_type == FILLET_PATH) {
+    // string pulled corners rounded by arcs, sampled straight from the analytic pieces
+    FilletPath fillet;
+    fillet.build(grid, pullString(grid, control), params.min_turn_radius);
+    if (params.flatness_tolerance > 0) return fillet.sampleAdaptive(params.flatness_tolerance);
+    return fillet.sample(params.path_spacing > 0 ? params.path_spacing : 10);
+  }
+  if (params.flatness_tolerance > 0) {
+    if (params.smooth_type != 0) return subdivideSpline(control, params.smooth_type, params.flatness_tolerance);
+    vector<Vec> result;
+    subdivideBezier(control, params.flatness_tolerance, result);
+    return result;
+  }
+  // sample densely in t, then respace evenly along the arc length
+  numPoints = max(numPoints, 1);
+  if (params.path_spacing > 0) numPoints *= 4;
+  vector<Vec> curve;
+  if (params.smooth_type == 0) scratch.evaluator.evaluate(control, numPoints, curve);
+  else curve = evaluateSpline(control, params.smooth_type, numPoints);
+  if (params.path_spacing <= 0) return curve;
+  ArcLengthTable table;
+  table.build(curve);
+  return table.resample(params.path_spacing);
+}
+
+vector<Vec> Planner::padCorners(const vector<Vec>& path, int curvature, bool ignore_head) {
+  // repeats every turning node so the Bezier is pulled closer to the corners
+  if (!ignore_head && path.size() < 5) return path;
+  if (ignore_head && path.size() < 3) return path;
+
+  auto get_dir_func = [](Vec point1, Vec point2) {
+    Vec delta = point1-point2;
+    if (delta.x > 0 && delta.y == 0) return 1;
+    if (delta.x > 0 && delta.y > 0) return 2;
+    if (delta.x > 0 && delta.y < 0) return 3;
+    if (delta.x < 0 && delta.y == 0) return 4;
+    if (delta.x < 0 && delta.y > 0) return 5;
+    if (delta.x < 0 && delta.y < 0) return 6;
+    if (delta.x == 0 && delta.y > 0) return 7;
+    if (delta.x == 0 && delta.y < 0) return 8;
+    return -1;
+  };
+
+  vector<Vec> filter_path;
+  filter_path.push_back(path[0]);
+  size_t start_index;
+  if (!ignore_head) {
+    start_index = 2;
+    filter_path.push_back(path[1]);
+  } else {
+    start_index = 1;
+  }
+  size_t i = start_index;
+  int dir = get_dir_func(path[start_index-1], path[start_index]);
+  while (i != path.size()-start_index) {
+    int new_dir = get_dir_func(path[i], path[i+1]);
+    if (dir != new_dir) {
+      for (int j = 0; j < curvature; j++) filter_path.push_back(path[i]);
+      dir = new_dir;
+    } else {
+      filter_path.push_back(path[i]);
+    }
+    i++;
+  }
+  if (!ignore_head) filter_path.push_back(path[path.size()-2]);
+  filter_path.push_back(path[path.size()-1]);
+  return filter_path;
+}
@@ -0,0 +1,258 @@
+#include "protocol.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <chrono>
+
+// little endian regardless of the host
+static void putUint32(string& out, uint32_t value) {
+  for (int k = 0; k < 4; k++) out.push_back(static_cast<char>((value >> (8 * k)) & 0xFF));
+}
+
+static uint32_t getUint32(const string& in, size_t offset) {
+  uint32_t value = 0;
+  for (int k = 0; k < 4; k++) value |= static_cast<uint32_t>(static_cast<uint8_t>(in[offset + k])) << (8 * k);
+  return value;
+}
+
+static void putFloat(string& out, double value) {
+  float narrow = static_cast<float>(value);
+  uint32_t bits;
+  memcpy(&bits, &narrow, 4);
+  putUint32(out, bits);
+}
+
+static double getFloat(const string& in, size_t offset) {
+  uint32_t bits = getUint32(in, offset);
+  float narrow;
+  memcpy(&narrow, &bits, 4);
+  return narrow;
+}
+
+static void putVarint(string& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+static bool getVarint(const string& in, size_t& offset, uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && offset < in.size(); shift += 7) {
+    uint8_t byte = static_cast<uint8_t>(in[offset++]);
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+// small magnitudes of either sign become small unsigned values
+static uint64_t zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+static void putHeader(string& out, FrameType type) {
+  out.push_back(static_cast<char>(FRAME_MAGIC));
+  out.push_back(static_cast<char>(PROTOCOL_VERSION));
+  out.push_back(static_cast<char>(type));
+  out.push_back(0);
+}
+
+string encodePose(const PoseFrame& pose) {
+  string out;
+  out.reserve(POSE_FRAME_SIZE);
+  putHeader(out, FRAME_POSE);
+  for (double value : { pose.x, pose.y, pose.dir, pose.target_x, pose.target_y, pose.cross_track,
+                        pose.avoidance_us, pose.validity_us, pose.snapshot_us }) {
+    putFloat(out, value);
+  }
+  putUint32(out, pose.step);
+  return out;
+}
+
+string encodePath(FrameType type, const vector<Vec>& path) {
+  string out;
+  out.reserve(FRAME_HEADER_SIZE + 5 + path.size() * 4);
+  putHeader(out, type);
+  putVarint(out, path.size());
+  int64_t last_x = 0, last_y = 0;
+  for (auto &point : path) {
+    int64_t x = llround(point.x * PATH_RESOLUTION), y = llround(point.y * PATH_RESOLUTION);
+    putVarint(out, zigzag(x - last_x));
+    putVarint(out, zigzag(y - last_y));
+    last_x = x;
+    last_y = y;
+  }
+  return out;
+}
+
+int frameType(const string& frame) {
+  if (frame.size() < FRAME_HEADER_SIZE) return -1;
+  if (static_cast<uint8_t>(frame[0]) != FRAME_MAGIC || static_cast<uint8_t>(frame[1]) != PROTOCOL_VERSION) return -1;
+  int type = static_cast<uint8_t>(frame[2]);
+  return type > 0 && type < FRAME_TYPE_COUNT ? type : -1;
+}
+
+bool decodePose(const string& frame, PoseFrame& pose) {
+  // fixed size, anything longer is not a frame this version wrote
+  if (frameType(frame) != FRAME_POSE || frame.size() != POSE_FRAME_SIZE) return false;
+  double *fields[9] = { &pose.x, &pose.y, &pose.dir, &pose.target_x, &pose.target_y, &pose.cross_track,
+                        &pose.avoidance_us, &pose.validity_us, &pose.snapshot_us };
+  size_t offset = FRAME_HEADER_SIZE;
+  for (auto field : fields) {
+    *field = getFloat(frame, offset);
+    offset += 4;
+  }
+  pose.step = getUint32(frame, offset);
+  return true;
+}
+
+bool decodePath(const string& frame, vector<Vec>& path) {
+  int type = frameType(frame);
+  if (type != FRAME_ASTAR_PATH && type != FRAME_BEZIER_PATH) return false;
+  size_t offset = FRAME_HEADER_SIZE;
+  uint64_t count;
+  // every point takes at least two bytes, a larger count is a broken frame
+  if (!getVarint(frame, offset, count) || count > (frame.size() - offset) / 2) return false;
+  path.clear();
+  path.reserve(count);
+  int64_t x = 0, y = 0;
+  for (uint64_t k = 0; k < count; k++) {
+    uint64_t dx, dy;
+    if (!getVarint(frame, offset, dx) || !getVarint(frame, offset, dy)) return false;
+    x += unzigzag(dx);
+    y += unzigzag(dy);
+    path.push_back(Vec(x / PATH_RESOLUTION, y / PATH_RESOLUTION));
+  }
+  // the last point ends the frame
+  return offset == frame.size();
+}
+
+json poseJson(const PoseFrame& pose, bool with_target) {
+  json data;
+  data["type"] = "position";
+  data["value"]["x"] = pose.x;
+  data["value"]["y"] = pose.y;
+  data["value"]["dir"] = pose.dir;
+  data["value"]["avoidance_us"] = pose.avoidance_us;
+  data["value"]["snapshot_us"] = pose.snapshot_us;
+  if (with_target) {
+    data["value"]["validity_us"] = pose.validity_us;
+    data["value"]["cross_track"] = pose.cross_track;
+    data["value"]["target"]["x"] = pose.target_x;
+    data["value"]["target"]["y"] = pose.target_y;
+  }
+  return data;
+}
+
+string pathJson(const string& type, const vector<Vec>& path) {
+  json data;
+  data["type"] = type;
+  data["value"] = json::array();
+  for (auto &item : path) {
+    json point;
+    point["x"] = item.x;
+    point["y"] = item.y;
+    data["value"].push_back(point);
+  }
+  return to_string(data);
+}
+
+string obstaclesJson(unsigned int sequence, unsigned int base, double radius, const vector<EnemyShape>& shapes) {
+  json data;
+  data["type"] = "obstacles";
+  data["seq"] = sequence;
+  data["base"] = base;
+  data["radius"] = radius;
+  data["value"] = json::array();
+  for (auto &shape : shapes) {
+    json item;
+    item["id"] = shape.id;
+    item["centers"] = json::array();
+    for (auto &center : shape.centers) item["centers"].push_back(json{{"x", center.x}, {"y", center.y}});
+    data["value"].push_back(item);
+  }
+  return to_string(data);
+}
+
+string obstaclesAckJson(unsigned int sequence) {
+  json data;
+  data["type"] = "obstacles_ack";
+  data["seq"] = sequence;
+  return to_string(data);
+}
+
+static double elapsedUs(chrono::steady_clock::time_point since) {
+  return chrono::duration<double, micro>(chrono::steady_clock::now() - since).count();
+}
+
+string encodePoseMessage(const PoseFrame& pose, bool binary, bool with_target, ProtocolStats& stats) {
+  auto start = chrono::steady_clock::now();
+  if (binary && stats.getMessages(FRAME_POSE) % JSON_SAMPLE_INTERVAL != 0) {
+    string frame = encodePose(pose);
+    stats.record(FRAME_POSE, frame.size(), elapsedUs(start));
+    return frame;
+  }
+  string message = to_string(poseJson(pose, with_target));
+  stats.recordJson(FRAME_POSE, message.size(), elapsedUs(start));
+  if (!binary) return message;
+  // sampled, the JSON was only made for the comparison
+  start = chrono::steady_clock::now();
+  string frame = encodePose(pose);
+  stats.record(FRAME_POSE, frame.size(), elapsedUs(start));
+  return frame;
+}
+
+const char* frameName(int type) {
+  switch (type) {
+    case FRAME_POSE: return "pose";
+    case FRAME_ASTAR_PATH: return "astar_path";
+    case FRAME_BEZIER_PATH: return "bezier_path";
+    default: return "unknown";
+  }
+}
+
+void ProtocolStats::record(int type, size_t bytes, double us) {
+  if (type <= 0 || type >= FRAME_TYPE_COUNT) return;
+  entries[type].messages++;
+  entries[type].bytes += bytes;
+  entries[type].us += us;
+}
+
+void ProtocolStats::recordJson(int type, size_t bytes, double us) {
+  if (type <= 0 || type >= FRAME_TYPE_COUNT) return;
+  entries[type].json_messages++;
+  entries[type].json_bytes += bytes;
+  entries[type].json_us += us;
+}
+
+string ProtocolStats::report() {
+  ostringstream out;
+  for (int type = 1; type < FRAME_TYPE_COUNT; type++) {
+    Entry &entry = entries[type];
+    if (entry.messages == 0 && entry.json_messages == 0) continue;
+    out << frameName(type) << ":";
+    double bytes = 0, us = 0, json_bytes = 0, json_us = 0;
+    if (entry.messages > 0) {
+      bytes = static_cast<double>(entry.bytes) / entry.messages;
+      us = entry.us / entry.messages;
+      out << " binary " << entry.messages << " msgs, " << bytes << " B, " << us << " us;";
+    }
+    if (entry.json_messages > 0) {
+      json_bytes = static_cast<double>(entry.json_bytes) / entry.json_messages;
+      json_us = entry.json_us / entry.json_messages;
+      out << " json " << entry.json_messages << " msgs, " << json_bytes << " B, " << json_us << " us;";
+    }
+    if (entry.messages > 0 && entry.json_messages > 0) {
+      out << " saved " << (json_bytes - bytes) * entry.messages << " B and "
+          << (json_us - us) * entry.messages << " us";
+    }
+    out << "\n";
+  }
+  return out.str();
+}
@@ -0,0 +1,92 @@
+#include "reach_field.hpp"
+
+#include <queue>
+#include <thread>
+#include <functional>
+
+const double UNREACHABLE = numeric_limits<double>::infinity();
+
+void ReachField::reset() {
+  fields.clear();
+  sources.clear();
+  dominance.clear();
+  owner.clear();
+  grid_version = 0;
+}
+
+void ReachField::update(OccupancyGrid& grid, const vector<Vec>& enemies, double speed) {
+  bool rebuild = grid.getVersion() != grid_version || speed != field_speed ||
+    enemies.size() != fields.size() || dominance.size() != grid.getSize();
+  if (rebuild) {
+    fields.assign(enemies.size(), vector<double>());
+    sources.assign(enemies.size(), {-1, -1});
+    grid_version = grid.getVersion();
+    field_speed = speed;
+  }
+
+  // only enemies that changed cell get a new field, each on its own thread
+  vector<thread> workers;
+  recomputed = 0;
+  for (size_t k = 0; k < enemies.size(); k++) {
+    pair<int, int> cell;
+    grid.toCell(enemies[k], cell.first, cell.second);
+    if (!fields[k].empty() && cell == sources[k]) continue;
+    sources[k] = cell;
+    Vec source = enemies[k];
+    workers.emplace_back(propagate, ref(grid), source, speed, ref(fields[k]));
+    recomputed++;
+  }
+  for (auto &worker : workers) worker.join();
+  if (recomputed == 0 && !rebuild) return;
+
+  dominance.assign(grid.getSize(), UNREACHABLE);
+  owner.assign(grid.getSize(), -1);
+  for (size_t k = 0; k < fields.size(); k++) {
+    for (size_t cell = 0; cell < fields[k].size(); cell++) {
+      if (fields[k][cell] < dominance[cell]) {
+        dominance[cell] = fields[k][cell];
+        owner[cell] = k;
+      }
+    }
+  }
+}
+
+void ReachField::propagate(OccupancyGrid& grid, Vec source, double speed, vector<double>& field) {
+  typedef pair<double, size_t> Entry;
+  const int di[8] = { 0, 1, 0, -1, -1, 1, -1, 1 };
+  const int dj[8] = { 1, 0, -1, 0, -1, 1, 1, -1 };
+  double node_distance = grid.getNodeDistance();
+  int cols = grid.getCols();
+
+  field.assign(grid.getSize(), UNREACHABLE);
+  priority_queue<Entry, vector<Entry>, greater<Entry>> open;
+
+  // seed the cells around the off-grid source with their straight line time
+  int base_i = static_cast<int>(floor(source.x / node_distance));
+  int base_j = static_cast<int>(floor(source.y / node_distance));
+  for (int i = base_i; i <= base_i + 1; i++) {
+    for (int j = base_j; j <= base_j + 1; j++) {
+      if (grid.blocked(i, j)) continue;
+      size_t cell = grid.index(i, j);
+      field[cell] = (grid.toPoint(i, j) - source).len() / speed;
+      open.push({field[cell], cell});
+    }
+  }
+
+  while (!open.empty()) {
+    Entry entry = open.top();
+    open.pop();
+    if (entry.first > field[entry.second]) continue;
+    int i = entry.second % cols, j = entry.second / cols;
+    for (int k = 0; k < 8; k++) {
+      int ni = i + di[k], nj = j + dj[k];
+      if (grid.blocked(ni, nj)) continue;
+      size_t next = grid.index(ni, nj);
+      double time = entry.first + (k < 4 ? node_distance : node_distance * M_SQRT2) / speed;
+      if (time < field[next]) {
+        field[next] = time;
+        open.push({time, next});
+      }
+    }
+  }
+}
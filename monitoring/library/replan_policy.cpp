@@ -0,0 +1,136 @@
+#include "replan_policy.hpp"
+
+#include <sstream>
+#include <algorithm>
+
+static const char* const REASON_NAMES[] = {"blocked", "clearance", "improvement"};
+
+const char* replanReasonName(int reason) {
+  if (reason < 0 || reason >= REPLAN_REASON_COUNT) return "start";
+  return REASON_NAMES[reason];
+}
+
+ReplanPolicy::ReplanPolicy(const GlobalData& global) {
+  interval = global.replan_interval;
+  min_clearance = global.replan_clearance;
+  min_improvement = global.replan_improvement;
+  // farther enemies move before the robot gets there, the grid covers them
+  horizon = global.neighbor_distance;
+  enemy_radius = global.robot_radius/2;
+}
+
+void ReplanPolicy::setPath(const vector<Vec>& path, const OccupancyGrid& grid) {
+  points = path;
+  validator.setPath(path);
+  corridor.assign(grid.getSize(), 0);
+  // half a node apart, so no square a segment crosses is skipped
+  double step = grid.getNodeDistance()/2;
+  auto mark = [&](Vec point) {
+    int ci, cj;
+    grid.toCell(point, ci, cj);
+    for (int i = ci-1; i <= ci+1; i++) {
+      for (int j = cj-1; j <= cj+1; j++) {
+        if (grid.inside(i, j)) corridor[grid.index(i, j)] = 1;
+      }
+    }
+  };
+  for (size_t k = 0; k < points.size(); k++) {
+    mark(points[k]);
+    if (k+1 == points.size()) break;
+    Vec delta = points[k+1] - points[k];
+    int parts = static_cast<int>(delta.len() / step);
+    for (int p = 1; p <= parts; p++) mark(points[k] + delta * (static_cast<double>(p) / (parts+1)));
+  }
+  grid_dirty = true;
+  plan_clearance = -1;
+}
+
+void ReplanPolicy::invalidate(const vector<size_t>& changed, const OccupancyGrid& grid) {
+  int cols = grid.getCols();
+  for (size_t cell : changed) {
+    int i = cell % cols, j = cell / cols;
+    if (!grid.blocked(i, j)) freed.push_back(grid.toPoint(i, j));
+    else if (cell < corridor.size() && corridor[cell]) grid_dirty = true;
+  }
+}
+
+ReplanDecision ReplanPolicy::check(const WorldSnapshot& world, size_t path_index, chrono::steady_clock::time_point now) {
+  if (points.size() < 2 || path_index >= points.size() - 1) return ReplanDecision();
+  checks++;
+  size_t from = path_index > 0 ? path_index - 1 : 0;
+
+  // the enemy circles move every step and are cheap, the grid only matters once it changed near the path
+  validator.setEnemies(*world.enemies, enemy_radius);
+  const OccupancyGrid* grid = grid_dirty ? world.grid.get() : nullptr;
+  if (grid) grid_walks++;
+  int invalid = validator.firstInvalid(from, grid);
+  if (invalid >= 0) return decide(REPLAN_BLOCKED, true, now);
+  if (grid) grid_dirty = false;
+
+  double current = clearance(*world.enemies, from);
+  if (plan_clearance < 0) plan_clearance = current;
+  if (current < min_clearance) {
+    // the local repair only sees the grid, an enemy this close needs a new search
+    if (current < plan_clearance - CLEARANCE_TOLERANCE) {
+      ReplanDecision decision = decide(REPLAN_CLEARANCE, false, now);
+      // until the new plan is adopted only a further drop asks again
+      if (decision.reason >= 0) plan_clearance = current;
+      return decision;
+    }
+    skipped[REPLAN_CLEARANCE]++;
+  }
+
+  if (!freed.empty()) {
+    // no path through a freed cell is shorter than the straight lines to and from it
+    double remaining = remainingLength(from);
+    double best = remaining;
+    for (auto &cell : freed) best = min(best, (cell - world.robot).len() + (points.back() - cell).len());
+    if (remaining - best > min_improvement * remaining) {
+      ReplanDecision decision = decide(REPLAN_IMPROVEMENT, false, now);
+      // a throttled estimate is looked at again
+      if (decision.reason >= 0) freed.clear();
+      return decision;
+    }
+    skipped[REPLAN_IMPROVEMENT]++;
+    freed.clear();
+  }
+  return ReplanDecision();
+}
+
+ReplanDecision ReplanPolicy::decide(int reason, bool local, chrono::steady_clock::time_point now) {
+  ReplanDecision decision;
+  if (now - last_replan < chrono::duration<double>(interval)) {
+    skipped[reason]++;
+    return decision;
+  }
+  last_replan = now;
+  triggered[reason]++;
+  decision.reason = reason;
+  decision.local = local;
+  return decision;
+}
+
+double ReplanPolicy::clearance(const vector<Vec>& enemies, size_t from) {
+  double nearest = 1e9, travelled = 0;
+  for (size_t k = from; k < points.size() && travelled <= horizon; k++) {
+    if (k > from) travelled += (points[k] - points[k-1]).len();
+    for (auto &enemy : enemies) nearest = min(nearest, (points[k] - enemy).len());
+  }
+  return nearest;
+}
+
+double ReplanPolicy::remainingLength(size_t from) {
+  double length = 0;
+  for (size_t k = from+1; k < points.size(); k++) length += (points[k] - points[k-1]).len();
+  return length;
+}
+
+string ReplanPolicy::report() {
+  ostringstream out;
+  out << "replans:";
+  for (int reason = 0; reason < REPLAN_REASON_COUNT; reason++) {
+    out << (reason ? ", " : " ") << REASON_NAMES[reason] << " " << triggered[reason] << " (skipped " << skipped[reason] << ")";
+  }
+  out << "; " << checks << " checks, " << grid_walks << " grid walks\n";
+  return out.str();
+}
@@ -0,0 +1,136 @@
+#include "spline.hpp"
+#include "bezier.hpp"
+
+void SplinePath::setType(int type_) {
+  if (type == type_) return;
+  type = type_;
+  vector<Vec> temp = points;
+  int numPoints = 0;
+  for (auto &item : segment_samples) numPoints += item.size();
+  setPoints(temp, max(numPoints, 1));
+}
+
+size_t SplinePath::padding() {
+  // b-spline ends are clamped by tripling the end points, catmull-rom reflects them
+  return type == UNIFORM_BSPLINE ? 2 : 1;
+}
+
+void SplinePath::updatePadding() {
+  size_t n = points.size(), pad = padding();
+  padded.resize(n + 2 * pad);
+  for (size_t i = 0; i < n; i++) padded[i + pad] = points[i];
+  for (size_t i = 0; i < pad; i++) {
+    if (type == UNIFORM_BSPLINE || n < 2) {
+      padded[i] = points[0];
+      padded[n + pad + i] = points[n-1];
+    } else {
+      padded[i] = points[0] * 2 - points[1];
+      padded[n + pad + i] = points[n-1] * 2 - points[n-2];
+    }
+  }
+}
+
+void SplinePath::setPoints(const vector<Vec>& points_, int numPoints) {
+  points.clear();
+  for (auto &point : points_) {
+    if (points.empty() || !(points.back() == point)) points.push_back(point);
+  }
+  segment_samples.clear();
+  samples.clear();
+  changed = true;
+  if (points.size() < 2) {
+    samples = points;
+    return;
+  }
+
+  double length = 0;
+  for (size_t i = 1; i < points.size(); i++) length += (points[i] - points[i-1]).len();
+  spacing = max(length / max(numPoints, 1), 1e-6);
+
+  updatePadding();
+  segment_samples.resize(padded.size() - 3);
+}
+
+vector<Vec>& SplinePath::getSamples() {
+  if (!changed) return samples;
+  for (size_t i = 0; i < segment_samples.size(); i++) evaluateSegment(i);
+  if (!segment_samples.empty()) {
+    samples.clear();
+    for (auto &item : segment_samples) samples.insert(samples.end(), item.begin(), item.end());
+    Vec control[4];
+    getSegmentBezier(segment_samples.size()-1, control);
+    samples.push_back(control[3]);
+  }
+  changed = false;
+  return samples;
+}
+
+vector<Vec> SplinePath::getAdaptiveSamples(double tolerance) {
+  if (segment_samples.empty()) return points;
+  vector<Vec> result, control(4);
+  for (size_t i = 0; i < segment_samples.size(); i++) {
+    getSegmentBezier(i, control.data());
+    subdivideBezier(control, tolerance, result);
+  }
+  return result;
+}
+
+void SplinePath::getSegmentBezier(size_t index, Vec* control) {
+  Vec p0 = padded[index], p1 = padded[index+1], p2 = padded[index+2], p3 = padded[index+3];
+  switch (type) {
+    case UNIFORM_BSPLINE:
+      control[0] = (p0 + p1 * 4 + p2) / 6;
+      control[1] = (p1 * 2 + p2) / 3;
+      control[2] = (p1 + p2 * 2) / 3;
+      control[3] = (p1 + p2 * 4 + p3) / 6;
+      break;
+
+    case UNIFORM_CATMULL_ROM:
+      control[0] = p1;
+      control[1] = p1 + (p2 - p0) / 6;
+      control[2] = p2 - (p3 - p1) / 6;
+      control[3] = p2;
+      break;
+
+    default: {
+      // centripetal parameterization, knot spacing sqrt of chord length
+      double d0 = max(sqrt((p1 - p0).len()), 1e-6);
+      double d1 = max(sqrt((p2 - p1).len()), 1e-6);
+      double d2 = max(sqrt((p3 - p2).len()), 1e-6);
+      Vec m1 = ((p1 - p0) / d0 - (p2 - p0) / (d0 + d1) + (p2 - p1) / d1) * d1;
+      Vec m2 = ((p2 - p1) / d1 - (p3 - p1) / (d1 + d2) + (p3 - p2) / d2) * d1;
+      control[0] = p1;
+      control[1] = p1 + m1 / 3;
+      control[2] = p2 - m2 / 3;
+      control[3] = p2;
+      break;
+    }
+  }
+}
+
+void SplinePath::evaluateSegment(size_t index) {
+  Vec control[4];
+  getSegmentBezier(index, control);
+  double chord = (control[3] - control[0]).len();
+  int count = max(1, static_cast<int>(round(chord / spacing)));
+
+  vector<Vec> &result = segment_samples[index];
+  result.resize(count);
+  for (int i = 0; i < count; i++) {
+    double t = static_cast<double>(i) / count, s = 1 - t;
+    result[i] = control[0] * (s * s * s) + control[1] * (3 * s * s * t) +
+      control[2] * (3 * s * t * t) + control[3] * (t * t * t);
+  }
+}
+
+vector<Vec> evaluateSpline(const vector<Vec>& points, int type, int numPoints) {
+  SplinePath spline(type);
+  spline.setPoints(points, numPoints);
+  return spline.getSamples();
+}
+
+vector<Vec> subdivideSpline(const vector<Vec>& points, int type, double tolerance) {
+  SplinePath spline(type);
+  spline.setPoints(points, 1);
+  return spline.getAdaptiveSamples(tolerance);
+}
@@ -0,0 +1,132 @@
+#include "tracker.hpp"
+
+#include <chrono>
+
+// white noise acceleration (cm/s^2)^2 and gps noise cm^2
+const double ACCEL_NOISE = 400.0;
+const double MEASUREMENT_NOISE = 4.0;
+// below this speed the heading is too noisy to estimate a turn rate
+const double TURN_MIN_SPEED = 2.0;
+
+// KalmanTrack implementation
+KalmanTrack::KalmanTrack(Vec position, double time) {
+  last_time = time;
+  for (int axis = 0; axis < 2; axis++) {
+    state[axis][0] = axis == 0 ? position.x : position.y;
+    state[axis][1] = 0;
+    covariance[axis][0][0] = MEASUREMENT_NOISE;
+    covariance[axis][0][1] = covariance[axis][1][0] = 0;
+    covariance[axis][1][1] = 100.0 * 100.0;
+  }
+}
+
+void KalmanTrack::propagate(double dt) {
+  double dt2 = dt * dt, dt3 = dt2 * dt, dt4 = dt3 * dt;
+  for (int axis = 0; axis < 2; axis++) {
+    double (&p)[2][2] = covariance[axis];
+    state[axis][0] += state[axis][1] * dt;
+    // P = F P F' + Q
+    double p00 = p[0][0] + dt * (p[1][0] + p[0][1]) + dt2 * p[1][1] + ACCEL_NOISE * dt4 / 4;
+    double p01 = p[0][1] + dt * p[1][1] + ACCEL_NOISE * dt3 / 2;
+    double p11 = p[1][1] + ACCEL_NOISE * dt2;
+    p[0][0] = p00;
+    p[0][1] = p[1][0] = p01;
+    p[1][1] = p11;
+  }
+}
+
+void KalmanTrack::update(Vec measurement, double time) {
+  double dt = time - last_time;
+  Vec old_velocity = getVelocity();
+  if (dt > 0) propagate(dt);
+
+  for (int axis = 0; axis < 2; axis++) {
+    double (&p)[2][2] = covariance[axis];
+    double z = axis == 0 ? measurement.x : measurement.y;
+    double innovation = z - state[axis][0];
+    double s = p[0][0] + MEASUREMENT_NOISE;
+    double k0 = p[0][0] / s, k1 = p[1][0] / s;
+    state[axis][0] += k0 * innovation;
+    state[axis][1] += k1 * innovation;
+    double p00 = (1 - k0) * p[0][0];
+    double p01 = (1 - k0) * p[0][1];
+    double p11 = p[1][1] - k1 * p[0][1];
+    p[0][0] = p00;
+    p[0][1] = p[1][0] = p01;
+    p[1][1] = p11;
+  }
+
+  Vec velocity = getVelocity();
+  if (dt > 0 && updates > 1 && old_velocity.len() > TURN_MIN_SPEED && velocity.len() > TURN_MIN_SPEED) {
+    double delta = atan2(velocity.y, velocity.x) - atan2(old_velocity.y, old_velocity.x);
+    if (delta > M_PI) delta -= 2 * M_PI;
+    else if (delta < -M_PI) delta += 2 * M_PI;
+    turn_rate = turn_rate * 0.7 + (delta / dt) * 0.3;
+  } else if (velocity.len() <= TURN_MIN_SPEED) {
+    turn_rate = 0;
+  }
+  last_time = time;
+  updates++;
+}
+
+Vec KalmanTrack::predict(double time) {
+  return predictPath(time, 0, 0).front();
+}
+
+vector<Vec> KalmanTrack::predictPath(double time, double horizon, double step) {
+  // extrapolate from the last estimate, turning the velocity at the estimated rate
+  vector<Vec> result;
+  Vec position = getPosition(), velocity = getVelocity();
+  double t = last_time;
+  int samples = step > 0 ? static_cast<int>(horizon / step) : 0;
+  for (int i = 0; i <= samples; i++) {
+    double sample_time = time + i * step;
+    while (t < sample_time - 1e-9) {
+      double dt = min(0.05, sample_time - t);
+      double angle = turn_rate * dt;
+      velocity = Vec(
+        velocity.x * cos(angle) - velocity.y * sin(angle),
+        velocity.x * sin(angle) + velocity.y * cos(angle));
+      position = position + velocity * dt;
+      t += dt;
+    }
+    result.push_back(position);
+  }
+  return result;
+}
+
+// EnemyTracker implementation
+EnemyTracker::~EnemyTracker() {
+  reset();
+}
+
+void EnemyTracker::update(size_t id, Vec position, double time) {
+  if (id >= tracks.size()) tracks.resize(id+1, nullptr);
+  if (tracks[id] == nullptr) tracks[id] = new KalmanTrack(position, time);
+  else tracks[id]->update(position, time);
+}
+
+void EnemyTracker::reset() {
+  for (auto track : tracks) delete track;
+  tracks.clear();
+}
+
+bool EnemyTracker::hasTrack(size_t id) {
+  return id < tracks.size() && tracks[id] != nullptr;
+}
+
+KalmanTrack* EnemyTracker::getTrack(size_t id) {
+  return hasTrack(id) ? tracks[id] : nullptr;
+}
+
+Vec EnemyTracker::predict(size_t id, double time) {
+  return tracks[id]->predict(time);
+}
+
+vector<Vec> EnemyTracker::predictPath(size_t id, double time, double horizon, double step) {
+  return tracks[id]->predictPath(time, horizon, step);
+}
+
+double EnemyTracker::now() {
+  return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -1,37 +1,7 @@
 #include "utils.hpp"
-// Vec implementation
-Vec::Vec(double x, double y) {
-    this->x = x;
-    this->y = y;
-}
-
-double Vec::len() {
-    return sqrt(x*x + y*y);
-}
-
-Vec Vec::operator+(Vec vec) {
-    return Vec(x + vec.x, y + vec.y);
-}
+#include "tracker.hpp"
+#include "obstacle_map.hpp"
 
-Vec Vec::operator-(Vec vec) {
-    return Vec(x - vec.x, y - vec.y);
-}
-
-Vec Vec::operator*(double scalar) {
-    return Vec(x * scalar, y * scalar);
-}
-
-Vec Vec::operator/(double scalar) {
-    return Vec(x / scalar, y / scalar);
-}
-
-bool Vec::operator==(Vec vec) {
-    return x == vec.x && y == vec.y;
-}
-
-ostream& operator<<(ostream &os, Vec vec) {
-    return os << "{" << vec.x << "," << vec.y << "}";
-}
 // utils private function
 Vec convertPoint(json point) {
   double x = point["x"].template get<double>();
@@ -46,19 +16,13 @@ json convertPoint(Vec point) {
   return data;
 }
 
-bool pointInField(Vec point, double width, double height) {
-  if (
-      point.x >= 0 && point.x <= width &&
-      point.y >= 0 && point.y <= height
-  ) return true;
-  return false;
-}
 // GlobalData implementation
 GlobalData::GlobalData(string dir_) {
   dir = dir_;
   global_filename = dir + "data/parameter.json";
   position_filename = dir + "data/position.json";
   worlds_filename = dir + "webots_ws/worlds/soccer.wbt";
+  tracker = make_shared<EnemyTracker>();
   try {
     loadFile();
     updateGlobal();
@@ -88,10 +52,31 @@ void GlobalData::updateGlobal() {
     heuristic_type = global["heuristic_type"].template get<int>();
     path_number = global["path_number"].template get<int>();
     bezier_curvature = global["bezier_curvature"].template get<int>();
+    max_speed = global["max_speed"].template get<double>();
+    neighbor_distance = global["neighbor_distance"].template get<double>();
+    time_horizon = global["time_horizon"].template get<double>();
+    prediction_horizon = global["prediction_horizon"].template get<double>();
+    reach_weight = global["reach_weight"].template get<double>();
+    approach_goals = global["approach_goals"].template get<int>();
+    approach_weight = global["approach_weight"].template get<double>();
+    opponent_goal = Vec(global["opponent_goal"]["x"].template get<double>(), global["opponent_goal"]["y"].template get<double>());
+    replan_window = global["replan_window"].template get<int>();
+    smooth_type = global["smooth_type"].template get<int>();
+    path_spacing = global["path_spacing"].template get<double>();
+    flatness_tolerance = global["flatness_tolerance"].template get<double>();
+    min_turn_radius = global["min_turn_radius"].template get<double>();
+    replan_interval = global["replan_interval"].template get<double>();
+    replan_clearance = global["replan_clearance"].template get<double>();
+    replan_improvement = global["replan_improvement"].template get<double>();
+    gait_ramp_periods = global["gait_ramp_periods"].template get<double>();
+    turn_per_period = global["turn_per_period"].template get<double>();
+    lookahead_distance = global["lookahead_distance"].template get<double>();
+    telemetry_rate = global["telemetry_rate"].template get<double>();
 }
 
 void GlobalData::updatePosition() {
   enemies.clear();
+  tracker->reset();
   robot = target = convertPoint(position[path_number]["robot"]);
   ball = convertPoint(position[path_number]["ball"]);
   for (auto &enemy : position[path_number]["enemies"]) {
@@ -100,31 +85,12 @@ void GlobalData::updatePosition() {
 }
 
 void GlobalData::updateObstacles() {
-  obstacles.clear();
-  obstacles_visible.clear();
-  for (auto &enemy : enemies) {
-      vector<Vec> obstacle_of_enemy, obstacle_of_enemy_visible;
-      Vec temp_point{
-          static_cast<int>(enemy.x / node_distance) * node_distance,
-          static_cast<int>(enemy.y / node_distance) * node_distance
-      };
-      int offset = static_cast<int>(robot_radius / node_distance + 1);
-
-      for (int i = -offset; i <= offset; i++) {
-          for (int j = -offset; j <= offset; j++) {
-              Vec neighbor = temp_point + Vec{i * node_distance, j * node_distance};
-              Vec delta = enemy - neighbor;
-              if (pointInField(neighbor, screen_width, screen_height)) {
-                if (delta.len() <= robot_radius)
-                  obstacle_of_enemy.push_back(neighbor);
-                if (delta.len() <= robot_radius/2)
-                  obstacle_of_enemy_visible.push_back(neighbor);
-              }
-          }
-      }
-      obstacles.push_back(obstacle_of_enemy);
-      obstacles_visible.push_back(obstacle_of_enemy_visible);
-  }
+  rasterizeShapes(trackedShapes(this, enemies, EnemyTracker::now()), makeObstacleParameters(this), obstacles, obstacles_visible);
+}
+
+void GlobalData::setBezierPath(const vector<Vec>& path) {
+  bezier_path = path;
+  bezier_version++;
 }
 
 void GlobalData::updateTargetPosition() {
@@ -0,0 +1,88 @@
+#include "velocity_profile.hpp"
+
+#include <fstream>
+#include <algorithm>
+
+// keeps cusps from stalling the profile, the gait turns in place there anyway
+const double MIN_SPEED_RATIO = 0.05;
+
+static double readConfigValue(const string& filename, const string& key, double fallback) {
+  ifstream file(filename);
+  string line;
+  while (getline(file, line)) {
+    size_t equal = line.find('=');
+    if (equal == string::npos) continue;
+    string name = line.substr(0, equal);
+    name.erase(name.find_last_not_of(" \t") + 1);
+    if (name != key) continue;
+    try {
+      return stod(line.substr(equal + 1));
+    } catch (...) {
+      return fallback;
+    }
+  }
+  return fallback;
+}
+
+ProfileLimits loadGaitLimits(GlobalData* global, const string& walking_config) {
+  // amplitude changes take effect per gait period, so both limits are counted in periods
+  double period = readConfigValue(walking_config, "period_time", 600.0) / 1000.0;
+  ProfileLimits limits;
+  limits.max_speed = global->max_speed;
+  limits.max_accel = global->max_speed / (global->gait_ramp_periods * period);
+  limits.max_turn_rate = global->turn_per_period * M_PI / 180.0 / period;
+  return limits;
+}
+
+// VelocityProfile implementation
+void VelocityProfile::build(const vector<Vec>& path, ProfileLimits limits, double start_speed, double end_speed) {
+  points.clear();
+  for (auto &point : path) {
+    if (points.empty() || !(points.back() == point)) points.push_back(point);
+  }
+  size_t n = points.size();
+  arcs.assign(n, 0.0);
+  speeds.assign(n, limits.max_speed);
+  times.assign(n, 0.0);
+  if (n < 2) return;
+
+  for (size_t i = 1; i < n; i++) arcs[i] = arcs[i-1] + (points[i] - points[i-1]).len();
+  // Menger curvature through each sample and its neighbours, turn rate bounds speed * curvature
+  double min_speed = limits.max_speed * MIN_SPEED_RATIO;
+  for (size_t i = 1; i + 1 < n; i++) {
+    Vec a = points[i] - points[i-1], b = points[i+1] - points[i], c = points[i+1] - points[i-1];
+    double denominator = a.len() * b.len() * c.len();
+    double curvature = denominator > 1e-9 ? 2 * fabs(a.x * b.y - a.y * b.x) / denominator : 0;
+    if (curvature > 1e-9) speeds[i] = max(min_speed, min(speeds[i], limits.max_turn_rate / curvature));
+  }
+
+  // forward pass for acceleration, backward pass for braking
+  speeds[0] = min(speeds[0], max(start_speed, 0.0));
+  speeds[n-1] = min(speeds[n-1], max(end_speed, 0.0));
+  for (size_t i = 1; i < n; i++) {
+    double ds = arcs[i] - arcs[i-1];
+    speeds[i] = min(speeds[i], sqrt(speeds[i-1] * speeds[i-1] + 2 * limits.max_accel * ds));
+  }
+  for (size_t i = n - 1; i > 0; i--) {
+    double ds = arcs[i] - arcs[i-1];
+    speeds[i-1] = min(speeds[i-1], sqrt(speeds[i] * speeds[i] + 2 * limits.max_accel * ds));
+  }
+
+  // constant acceleration inside each segment
+  for (size_t i = 1; i < n; i++) {
+    double ds = arcs[i] - arcs[i-1];
+    times[i] = times[i-1] + 2 * ds / max(speeds[i-1] + speeds[i], 1e-9);
+  }
+}
+
+double VelocityProfile::speedAtDistance(double s) {
+  if (points.size() < 2 || s >= getLength()) return speeds.empty() ? 0 : speeds.back();
+  if (s <= 0) return speeds.front();
+  auto it = upper_bound(arcs.begin(), arcs.end(), s);
+  size_t i = min(static_cast<size_t>(it - arcs.begin() - 1), points.size() - 2);
+  double ds = arcs[i+1] - arcs[i];
+  if (ds <= 0) return speeds[i];
+  // squared speed is linear in distance under constant acceleration
+  double v0 = speeds[i] * speeds[i], v1 = speeds[i+1] * speeds[i+1];
+  return sqrt(max(0.0, v0 + (v1 - v0) * (s - arcs[i]) / ds));
+}
@@ -0,0 +1,63 @@
+#include "world_model.hpp"
+
+WorldModel::WorldModel(GlobalData* global) {
+  node_distance = global->node_distance;
+  width = global->screen_width;
+  height = global->screen_height;
+
+  auto first = make_shared<WorldSnapshot>();
+  first->robot = global->robot;
+  first->ball = global->ball;
+  first->enemies = make_shared<const vector<Vec>>(global->enemies);
+  first->obstacles = make_shared<const vector<vector<Vec>>>(global->obstacles);
+  auto grid = make_shared<OccupancyGrid>(node_distance, width, height);
+  grid->build(global->obstacles);
+  first->grid = grid;
+  first->changed_cells = make_shared<const vector<size_t>>();
+  current = first;
+}
+
+void WorldModel::setRobot(Vec robot) {
+  update([&](WorldSnapshot& next) { next.robot = robot; });
+}
+
+void WorldModel::setBall(Vec ball) {
+  update([&](WorldSnapshot& next) { next.ball = ball; });
+}
+
+void WorldModel::setEnemies(const vector<Vec>& enemies) {
+  auto shared = make_shared<const vector<Vec>>(enemies);
+  update([&](WorldSnapshot& next) { next.enemies = shared; });
+}
+
+void WorldModel::setObstacles(const vector<vector<Vec>>& obstacles) {
+  // built before taking the writer lock, readers of the old grid are not affected
+  auto grid = make_shared<OccupancyGrid>(node_distance, width, height);
+  grid->build(obstacles);
+  auto shared = make_shared<const vector<vector<Vec>>>(obstacles);
+  update([&](WorldSnapshot& next) {
+    auto changed = make_shared<vector<size_t>>();
+    if (next.grid->getSize() == grid->getSize()) {
+      for (int j = 0; j < grid->getRows(); j++) {
+        for (int i = 0; i < grid->getCols(); i++) {
+          if (grid->blocked(i, j) != next.grid->blocked(i, j)) changed->push_back(grid->index(i, j));
+        }
+      }
+    }
+    next.obstacles = shared;
+    next.grid = grid;
+    next.changed_cells = changed;
+  });
+}
+
+void WorldModel::setObstacleMap(const ObstacleMap& obstacle_map) {
+  // the map keeps changing its grid, readers get their own copy
+  auto grid = make_shared<const OccupancyGrid>(obstacle_map.getGrid());
+  auto shared = make_shared<const vector<vector<Vec>>>(obstacle_map.getObstacles());
+  auto changed = make_shared<const vector<size_t>>(obstacle_map.getChanged());
+  update([&](WorldSnapshot& next) {
+    next.obstacles = shared;
+    next.grid = grid;
+    next.changed_cells = changed;
+  });
+}
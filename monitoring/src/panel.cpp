@@ -1,4 +1,7 @@
 #include "panel.hpp"
+#include "tracker.hpp"
+
+#include <chrono>
 
 Panel::Panel(GlobalData* global) : global(global) {
   setFixedSize(1240, 640);
@@ -370,13 +373,15 @@ void Panel::handleConnectButton() {
 
         global->isConnected = true;
         global->connected[0] = true;
+        obstacle_sync.reset();
+        sendHello(0);
         renderArea->render();
       });
-      connect(robotSocket[1], &QWebSocket::connected, this, [&](){ global->connected[1] = true; renderArea->render(); });
-      connect(robotSocket[2], &QWebSocket::connected, this, [&](){ global->connected[2] = true; renderArea->render(); });
-      connect(robotSocket[3], &QWebSocket::connected, this, [&](){ global->connected[3] = true; renderArea->render(); });
-      connect(robotSocket[4], &QWebSocket::connected, this, [&](){ global->connected[4] = true; renderArea->render(); });
-      connect(robotSocket[5], &QWebSocket::connected, this, [&](){ global->connected[5] = true; renderArea->render(); });
+      connect(robotSocket[1], &QWebSocket::connected, this, [&](){ global->connected[1] = true; sendHello(1); renderArea->render(); });
+      connect(robotSocket[2], &QWebSocket::connected, this, [&](){ global->connected[2] = true; sendHello(2); renderArea->render(); });
+      connect(robotSocket[3], &QWebSocket::connected, this, [&](){ global->connected[3] = true; sendHello(3); renderArea->render(); });
+      connect(robotSocket[4], &QWebSocket::connected, this, [&](){ global->connected[4] = true; sendHello(4); renderArea->render(); });
+      connect(robotSocket[5], &QWebSocket::connected, this, [&](){ global->connected[5] = true; sendHello(5); renderArea->render(); });
 
       connect(robotSocket[0], &QWebSocket::disconnected, this, [&](){
         if (global->isConnected) {
@@ -397,6 +402,7 @@ void Panel::handleConnectButton() {
           global->isConnected = false;
           global->isStart = false;
           global->connected[0] = false;
+          obstacle_sync.reset();
           renderArea->render();
         }
       });
@@ -406,12 +412,14 @@ void Panel::handleConnectButton() {
       connect(robotSocket[4], &QWebSocket::disconnected, this, [&](){ global->connected[4] = false; renderArea->render(); });
       connect(robotSocket[5], &QWebSocket::disconnected, this, [&](){ global->connected[5] = false; renderArea->render(); });
       
-      connect(robotSocket[0], &QWebSocket::textMessageReceived, this, [&](const QString& message) { handleSocketMessage(0, message.toStdString()); }); 
-      connect(robotSocket[1], &QWebSocket::textMessageReceived, this, [&](const QString& message) { handleSocketMessage(1, message.toStdString()); }); 
-      connect(robotSocket[2], &QWebSocket::textMessageReceived, this, [&](const QString& message) { handleSocketMessage(2, message.toStdString()); }); 
-      connect(robotSocket[3], &QWebSocket::textMessageReceived, this, [&](const QString& message) { handleSocketMessage(3, message.toStdString()); }); 
-      connect(robotSocket[4], &QWebSocket::textMessageReceived, this, [&](const QString& message) { handleSocketMessage(4, message.toStdString()); }); 
-      connect(robotSocket[5], &QWebSocket::textMessageReceived, this, [&](const QString& message) { handleSocketMessage(5, message.toStdString()); }); 
+      for (int i = 0; i < 6; i++) {
+        // QString is UTF-16, its UTF-8 bytes are parsed in place
+        connect(robotSocket[i], &QWebSocket::textMessageReceived, this, [this, i](const QString& message) {
+          QByteArray utf8 = message.toUtf8();
+          handleSocketMessage(i, utf8.constData(), utf8.size());
+        });
+        connect(robotSocket[i], &QWebSocket::binaryMessageReceived, this, [this, i](const QByteArray& message) { handleSocketFrame(i, message.toStdString()); });
+      }
     
       for (int i = 0; i < 6; i++) {
         QString url = "ws://127.0.0.1:" + QString::number(9000+i);
@@ -464,78 +472,120 @@ void Panel::handleTimer() {
   if (global->isStart) {
     global->timer += timer->interval();
     global->interval += timer->interval();
-    if (!global->isStatic && global->interval >= 3000) {
-      global->interval = 0;
-      global->updateObstacles();
 
+    // every robot avoids the others locally between global replans
+    for (int i = 0; i < 6; i++) {
+      if (!global->connected[i]) continue;
       json data;
-      data["type"] = "update";
+      data["type"] = "neighbors";
       data["value"] = json::array();
-      for (auto &obstacles : global->obstacles) {
-        json arr = json::array();
-        for (auto &obstacle : obstacles) {
-          json temp;
-          temp["x"] = obstacle.x;
-          temp["y"] = obstacle.y;
-          arr.push_back(temp);
-        }
-        data["value"].push_back(arr);
+      for (int j = 0; j < 6; j++) {
+        if (j == i) continue;
+        Vec point = j == 0 ? global->robot : global->enemies[j-1];
+        data["value"].push_back(json{{"x", point.x}, {"y", point.y}});
       }
-      robotSocket[0]->sendTextMessage(QString(to_string(data).c_str()));
+      robotSocket[i]->sendTextMessage(QString(to_string(data).c_str()));
+    }
+    if (!global->isStatic && global->interval >= 3000) {
+      global->interval = 0;
+      vector<EnemyShape> shapes = trackedShapes(global, global->enemies, EnemyTracker::now());
+      rasterizeShapes(shapes, makeObstacleParameters(global), global->obstacles, global->obstacles_visible);
+
+      // only the enemies the robot does not have yet, it rasterizes them itself
+      vector<EnemyShape> changed;
+      unsigned int sequence, base;
+      if (obstacle_sync.delta(shapes, global->robot_radius, changed, sequence, base)) {
+        robotSocket[0]->sendTextMessage(QString(obstaclesJson(sequence, base, global->robot_radius, changed).c_str()));
+      }
+    }
+  }
+}
+
+void Panel::sendHello(int i) {
+  // controllers that do not know the hello keep sending JSON
+  json data;
+  data["type"] = "hello";
+  data["protocol"] = PROTOCOL_VERSION;
+  data["formats"] = json::array({"binary", "json"});
+  robotSocket[i]->sendTextMessage(QString(to_string(data).c_str()));
+}
+
+void Panel::applyPose(int i, const PoseFrame& pose) {
+  if (i == 0) {
+    global->robot = Vec(pose.x, pose.y);
+    global->following_path.push_back(global->robot);
+    global->target = Vec(pose.target_x, pose.target_y);
+  } else {
+    global->enemies[i-1] = Vec(pose.x, pose.y);
+    global->tracker->update(i-1, global->enemies[i-1], EnemyTracker::now());
+  }
+  global->direction[i] = pose.dir;
+}
+
+void Panel::handleSocketFrame(int i, const string& frame) {
+  auto start = chrono::steady_clock::now();
+  int type = frameType(frame);
+  if (type == FRAME_POSE) {
+    PoseFrame pose;
+    if (!decodePose(frame, pose)) return;
+    decode_stats.record(type, frame.size(), chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    applyPose(i, pose);
+  } else if ((type == FRAME_ASTAR_PATH || type == FRAME_BEZIER_PATH) && i == 0) {
+    vector<Vec> path;
+    if (!decodePath(frame, path)) return;
+    decode_stats.record(type, frame.size(), chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    if (type == FRAME_ASTAR_PATH) {
+      global->astar_path = path;
+    } else {
+      global->setBezierPath(path);
+      global->normal_bezier_path.clear();
     }
   }
 }
 
-void Panel::handleSocketMessage(int i, string message) {
-  json recv_data = json::parse(message);
-  string type = recv_data["type"].template get<string>();
+void Panel::handleSocketMessage(int i, const char* data, size_t size) {
+  auto start = chrono::steady_clock::now();
+  if (!decodeMessage(data, size, message)) {
+    cout << "robot " << i << " sent malformed message" << endl;
+    return;
+  }
+  decode_stats.recordJson(messageFrame(message.type), size, chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+  if (message.type == MESSAGE_HELLO) {
+    cout << "robot " << i << " protocol: " << (message.binary ? "binary" : "json") << endl;
+    return;
+  }
   if (i == 0) { // robot
-    if (type == "position") {
-      global->robot = Vec(
-        recv_data["value"]["x"].template get<double>(),
-        recv_data["value"]["y"].template get<double>()
-      );
-      global->following_path.push_back(global->robot);
-      global->target = Vec(
-        recv_data["value"]["target"]["x"].template get<double>(),
-        recv_data["value"]["target"]["y"].template get<double>()
-      );
-      global->direction[0] = recv_data["value"]["dir"].template get<double>();
-    } else if (type == "astar_path") {
-      global->astar_path.clear();
-      for (auto &item : recv_data["value"]) {
-        global->astar_path.push_back(Vec(
-          item["x"].template get<double>(),
-          item["y"].template get<double>()
-        ));
-      }
-    } else if (type == "bezier_path") {
-      global->bezier_path.clear();
+    if (message.type == MESSAGE_POSITION) {
+      applyPose(i, message.pose);
+    } else if (message.type == MESSAGE_ASTAR_PATH) {
+      global->astar_path = message.points;
+    } else if (message.type == MESSAGE_BEZIER_PATH) {
+      global->setBezierPath(message.points);
       global->normal_bezier_path.clear();
-      for (auto &item : recv_data["value"]) {
-        global->bezier_path.push_back(Vec(
-          item["x"].template get<double>(),
-          item["y"].template get<double>()
-        ));
+    } else if (message.type == MESSAGE_OBSTACLES_ACK) {
+      obstacle_sync.acknowledge(message.sequence);
+    } else if (message.type == MESSAGE_PLAN_STATS) {
+      cout << "plan " << message.id << (message.local ? " (local)" : "")
+           << (message.reason.empty() ? "" : " for " + message.reason) << ": "
+           << message.plan_us << "us planning, " << message.latency_us << "us latency" << endl;
+    } else if (message.type == MESSAGE_FINISHED) {
+      if (message.has_value) {
+        cout << "time to ball: " << message.time << "s (planned " << message.planned << "s)" << endl;
       }
-    } else if (type == "finished") {
+      cout << "decode\n" << decode_stats.report() << flush;
       global->isStart = false;
       startButton->setEnabled(false);
       connectButton->setEnabled(true);
       // global->actual_path.push_back(global->robot);
     }
   } else { // enemy
-    if (type == "position") {
-      global->enemies[i-1] = Vec(
-        recv_data["value"]["x"].template get<double>(),
-        recv_data["value"]["y"].template get<double>()
-      );
-      global->direction[i] = recv_data["value"]["dir"].template get<double>();
-    } else if (type == "finished") {
+    if (message.type == MESSAGE_POSITION) {
+      applyPose(i, message.pose);
+    } else if (message.type == MESSAGE_FINISHED) {
       if (global->target_index[i-1] < global->target_position[i-1].size()) {
         Vec point = global->target_position[i-1][global->target_index[i-1]];
-        int target_x = recv_data["target"]["x"].template get<int>();
-        int target_y = recv_data["target"]["y"].template get<int>();
+        int target_x = static_cast<int>(message.target.x);
+        int target_y = static_cast<int>(message.target.y);
         if (abs(target_x-point.x) < global->robot_radius/2 && abs(target_y-point.y) < global->robot_radius/2)
           global->target_index[i-1]++;
         json data;
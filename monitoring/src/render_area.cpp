@@ -24,7 +24,7 @@ void RenderArea::setMode() {
       global->isConnected = false;
 
       global->astar_path.clear();
-      global->bezier_path.clear();
+      global->setBezierPath(vector<Vec>());
       global->normal_bezier_path.clear();
       global->visited_node.clear();
       global->following_path.clear();
@@ -58,8 +58,7 @@ void RenderArea::setMode() {
 
       global->obstacles.clear();
       global->obstacles.push_back(vector<Vec>());
-      generator->openList.clear();
-      generator->closeList.clear();
+      generator->clearSearch();
       break;
     }
 
@@ -67,7 +66,7 @@ void RenderArea::setMode() {
       global->isGenerate = false;
 
       global->astar_path.clear();
-      global->bezier_path.clear();
+      global->setBezierPath(vector<Vec>());
         global->normal_bezier_path.clear();
       global->control_points.clear();
       global->modified_astar_path.clear();
@@ -79,11 +78,11 @@ void RenderArea::setMode() {
 
 void RenderArea::setGeneratePath(bool value) {
   if (value) {
-    generator->generatePath();
+    generator->generateApproachPath();
     generator->generateSmoothPath(100);
   } else {
     global->astar_path.clear();
-    global->bezier_path.clear();
+    global->setBezierPath(vector<Vec>());
     global->normal_bezier_path.clear();
     global->visited_node.clear();
   }
@@ -94,25 +93,18 @@ bool RenderArea::setPathNext(bool val) {
     if (!global->isGenerate) {
       global->isGenerate = true;
 
-      generator->current = nullptr;
-      generator->openList.clear();
-      generator->closeList.clear();
-      
       if ((global->robot - global->ball).len() < global->robot_radius) {
+        generator->clearSearch();
         global->astar_path = vector<Vec>{global->robot, global->ball};
         return true;
       }
 
-      generator->openList.push_back(new Node(global->robot));
+      generator->setSearch(global->robot, vector<Goal>{Goal{global->ball, 0}});
     }
-    if (generator->openList.empty()) return true;
-    generator->astar_find_next_node();
-    if (generator->current->coordinate == global->ball) return true;
-    generator->astar_find_neighbors(true);
+    return generator->stepSearch();
   } else {
     global->isGenerate = false;
-    generator->openList.clear();
-    generator->closeList.clear();
+    generator->clearSearch();
   }
   return false;
 }
@@ -123,7 +115,7 @@ void RenderArea::setModifiedPath(bool val) {
   } else {
     global->astar_path.clear();
     global->modified_astar_path.clear();
-    global->bezier_path.clear();
+    global->setBezierPath(vector<Vec>());
     global->normal_bezier_path.clear();
     global->control_points.clear();
   }
@@ -350,21 +342,12 @@ void RenderArea::paintEvent(QPaintEvent* paintEvent) {
       // painter.drawText(700, 200, QString::number(global->timer));
       font.setPixelSize(30);
       painter.setFont(font);
-      for (auto &data : generator->openList) {
-        painter.setPen(Qt::white);
-        QPoint parent, child = transformPoint(data->coordinate);
-        painter.drawText(transformPoint(data->coordinate + Vec(-10, 20)), "(" + QString::number((int)data->G) + ", " + QString::number((int)data->H) + ")");
-        if (data->parent != nullptr) {
-          parent = transformPoint(data->parent->coordinate);
-          painter.drawLine(parent, child);
-        }
-      }
-      for (auto &data : generator->closeList) {
-        painter.setPen(Qt::black);
-        QPoint parent, child = transformPoint(data->coordinate);
-        painter.drawText(transformPoint(data->coordinate + Vec(-10, 20)), "(" + QString::number((int)data->G) + ", " + QString::number((int)data->H) + ")");
-        if (data->parent != nullptr) {
-          parent = transformPoint(data->parent->coordinate);
+      for (auto &data : generator->getSearchNodes()) {
+        painter.setPen(data.closed ? Qt::black : Qt::white);
+        QPoint parent, child = transformPoint(data.coordinate);
+        painter.drawText(transformPoint(data.coordinate + Vec(-10, 20)), "(" + QString::number((int)data.G) + ", " + QString::number((int)data.H) + ")");
+        if (data.has_parent) {
+          parent = transformPoint(data.parent);
           painter.drawLine(parent, child);
         }
       }
@@ -399,7 +382,7 @@ void RenderArea::paintEvent(QPaintEvent* paintEvent) {
           painter.drawLine(transformPoint(global->bezier_path[i]), transformPoint(global->bezier_path[i-1]));
       }
       if (global->control_points.size() > 1) {
-        for (size_t i = global->control_points.size()-1; i > global->control_points.size()-global->modified_astar_path.size(); i--) {
+        for (size_t i = 0; i < global->control_points.size(); i++) {
           for (size_t j = 0; j < global->control_points[i].size(); j++) {
             painter.drawEllipse(transformPoint(global->control_points[i][j]), 2, 2);
             if (j != 0) {
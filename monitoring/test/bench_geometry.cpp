@@ -0,0 +1,72 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+#include "path_generator.hpp"
+
+using namespace std;
+
+// best of a few runs, in us per call
+template <typename Function>
+static double timeCall(int calls, Function function) {
+  double best = 1e18;
+  for (int run = 0; run < 5; run++) {
+    auto start = chrono::steady_clock::now();
+    for (int k = 0; k < calls; k++) function();
+    best = min(best, chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+  }
+  return best / calls;
+}
+
+// the smoothing loop before BezierEvaluator, one de Casteljau pyramid per sample
+static vector<Vec> deCasteljau(const vector<Vec>& control, int numPoints) {
+  vector<Vec> result(numPoints+1);
+  for (int i = 0; i <= numPoints; ++i) {
+    double t = static_cast<double>(i) / numPoints;
+    vector<Vec> points = control;
+    int n = points.size();
+    for (int j = 1; j < n; ++j) {
+      for (int k = 0; k < n - j; ++k) {
+        points[k] = points[k]*(1 - t) + points[k + 1]*t;
+      }
+    }
+    result[i] = points[0];
+  }
+  return result;
+}
+
+// Bezier sampling, old loop against the current one,
+// run from monitoring/ or pass the repository root
+int main(int argc, char** argv) {
+  GlobalData global(argc > 1 ? argv[1] : "../");
+  PathGenerator generator(&global);
+  volatile double sink = 0;
+  cout << fixed << setprecision(2);
+
+  cout << "Bezier samples, de Casteljau vs " << BezierEvaluator::getKernelName() << " table, us per curve\n";
+  for (int scenario = 0; scenario < 5; scenario++) {
+    global.path_number = scenario;
+    global.updatePosition();
+    global.updateObstacles();
+    generator.generateApproachPath();
+    vector<Vec> control = global.astar_path;
+    int samples = max(2, static_cast<int>(generator.getAstarLength() / 10));
+
+    BezierEvaluator evaluator;
+    vector<Vec> table;
+    vector<Vec> reference = deCasteljau(control, samples);
+    evaluator.evaluate(control, samples, table);
+    double error = 0;
+    for (size_t i = 0; i < reference.size() && i < table.size(); i++) error = max(error, (reference[i] - table[i]).len());
+    if (table.size() != reference.size() || error > 1e-6) {
+      cout << "scenario " << scenario << " differs from de Casteljau by " << error << " px\n";
+      return 1;
+    }
+
+    double naive_us = timeCall(20, [&]() { sink = sink + deCasteljau(control, samples).back().x; });
+    double table_us = timeCall(200, [&]() { evaluator.evaluate(control, samples, table); sink = sink + table.back().x; });
+    cout << "  scenario " << scenario << ", degree " << setw(2) << control.size() - 1 << ", " << setw(3) << samples
+         << " samples: " << setw(8) << naive_us << " vs " << setw(6) << table_us << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,170 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <map>
+
+#include "message.hpp"
+
+using namespace std;
+
+// what the handlers read from a parsed json DOM before decodeMessage
+static void readDom(const json& data, Message& message) {
+  static const map<string, int> types = {
+    {"hello", MESSAGE_HELLO}, {"run", MESSAGE_RUN}, {"target", MESSAGE_TARGET}, {"neighbors", MESSAGE_NEIGHBORS},
+    {"obstacles", MESSAGE_OBSTACLES}, {"obstacles_ack", MESSAGE_OBSTACLES_ACK}, {"position", MESSAGE_POSITION},
+    {"astar_path", MESSAGE_ASTAR_PATH}, {"bezier_path", MESSAGE_BEZIER_PATH}, {"plan_stats", MESSAGE_PLAN_STATS},
+    {"finished", MESSAGE_FINISHED}
+  };
+  message.clear();
+  auto type = types.find(data["type"].get<string>());
+  if (type == types.end()) return;
+  message.type = type->second;
+  auto point = [](const json& item) { return Vec(item["x"].get<double>(), item["y"].get<double>()); };
+  if (data.contains("target")) {
+    message.has_target = true;
+    message.target = point(data["target"]);
+  }
+  switch (message.type) {
+    case MESSAGE_HELLO:
+      message.protocol = data["protocol"].get<int>();
+      if (data.contains("format")) message.binary = data["format"] == "binary";
+      if (data.contains("formats")) {
+        for (auto &format : data["formats"]) message.binary = message.binary || format == "binary";
+      }
+      break;
+    case MESSAGE_RUN:
+      message.start = data["value"] == "start";
+      break;
+    case MESSAGE_TARGET:
+      message.has_value = true;
+      message.has_target = true;
+      message.target = point(data["value"]);
+      message.pose.x = message.target.x;
+      message.pose.y = message.target.y;
+      break;
+    case MESSAGE_NEIGHBORS:
+    case MESSAGE_ASTAR_PATH:
+    case MESSAGE_BEZIER_PATH:
+      for (auto &item : data["value"]) message.points.push_back(point(item));
+      break;
+    case MESSAGE_OBSTACLES:
+      message.sequence = data["seq"].get<unsigned int>();
+      message.base = data["base"].get<unsigned int>();
+      message.radius = data["radius"].get<double>();
+      for (auto &item : data["value"]) {
+        EnemyShape shape;
+        shape.id = item["id"].get<int>();
+        for (auto &center : item["centers"]) shape.centers.push_back(point(center));
+        message.shapes.push_back(shape);
+      }
+      break;
+    case MESSAGE_OBSTACLES_ACK:
+      message.sequence = data["seq"].get<unsigned int>();
+      break;
+    case MESSAGE_POSITION: {
+      const json& value = data["value"];
+      message.has_value = true;
+      message.pose.x = value["x"].get<double>();
+      message.pose.y = value["y"].get<double>();
+      message.pose.dir = value["dir"].get<double>();
+      if (value.contains("target")) {
+        message.pose.target_x = value["target"]["x"].get<double>();
+        message.pose.target_y = value["target"]["y"].get<double>();
+      }
+      break;
+    }
+    case MESSAGE_PLAN_STATS: {
+      const json& value = data["value"];
+      message.has_value = true;
+      message.id = value["id"].get<unsigned int>();
+      message.local = value["local"].get<bool>();
+      message.reason = value["reason"].get<string>();
+      message.plan_us = value["plan_us"].get<double>();
+      message.latency_us = value["latency_us"].get<double>();
+      break;
+    }
+    case MESSAGE_FINISHED:
+      if (data.contains("value")) {
+        message.has_value = true;
+        message.time = data["value"]["time"].get<double>();
+        message.planned = data["value"]["planned"].get<double>();
+      }
+      break;
+  }
+}
+
+static bool samePoints(const vector<Vec>& a, const vector<Vec>& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t k = 0; k < a.size(); k++) {
+    if (!(a[k] == b[k])) return false;
+  }
+  return true;
+}
+
+static bool sameMessage(const Message& a, const Message& b) {
+  bool same = a.type == b.type && a.protocol == b.protocol && a.binary == b.binary && a.start == b.start &&
+              a.has_target == b.has_target && a.target == b.target && a.has_value == b.has_value &&
+              a.pose.x == b.pose.x && a.pose.y == b.pose.y && a.pose.dir == b.pose.dir &&
+              a.pose.target_x == b.pose.target_x && a.pose.target_y == b.pose.target_y &&
+              samePoints(a.points, b.points) && a.sequence == b.sequence && a.base == b.base && a.radius == b.radius &&
+              a.id == b.id && a.local == b.local && a.plan_us == b.plan_us && a.latency_us == b.latency_us &&
+              a.reason == b.reason && a.time == b.time && a.planned == b.planned && a.shapes.size() == b.shapes.size();
+  for (size_t k = 0; same && k < a.shapes.size(); k++) {
+    same = a.shapes[k].id == b.shapes[k].id && samePoints(a.shapes[k].centers, b.shapes[k].centers);
+  }
+  return same;
+}
+
+// best of a few runs, in us per message
+template <typename Decode>
+static double timeStream(const vector<const string*>& stream, Decode decode) {
+  double best = 1e18;
+  for (int run = 0; run < 7; run++) {
+    auto start = chrono::steady_clock::now();
+    for (auto text : stream) decode(*text);
+    best = min(best, chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+  }
+  return best / stream.size();
+}
+
+// replays a recorded message stream through the DOM reads and decodeMessage,
+// run from monitoring/ or pass the stream's path
+int main(int argc, char** argv) {
+  ifstream file(argc > 1 ? argv[1] : "test/messages.jsonl");
+  vector<string> stream;
+  for (string line; getline(file, line);) {
+    if (!line.empty()) stream.push_back(line);
+  }
+  if (stream.empty()) {
+    cout << "no messages to replay\n";
+    return 1;
+  }
+
+  // both readers agree before either is timed
+  map<string, vector<const string*>> by_type;
+  vector<const string*> all;
+  Message dom, sax;
+  for (auto &text : stream) {
+    json data = json::parse(text);
+    readDom(data, dom);
+    if (!decodeMessage(text, sax) || !sameMessage(dom, sax)) {
+      cout << "decodeMessage differs from the DOM on " << text.substr(0, 80) << "\n";
+      return 1;
+    }
+    by_type[data["type"].get<string>()].push_back(&text);
+    all.push_back(&text);
+  }
+
+  cout << stream.size() << " messages, DOM parse + reads vs SAX decodeMessage, us per message\n";
+  cout << fixed << setprecision(2);
+  auto report = [&](const string& name, const vector<const string*>& messages) {
+    double dom_us = timeStream(messages, [&](const string& text) { readDom(json::parse(text), dom); });
+    double sax_us = timeStream(messages, [&](const string& text) { decodeMessage(text, sax); });
+    cout << "  " << setw(14) << left << name << right << setw(5) << messages.size() << " msgs: "
+         << setw(8) << dom_us << " vs " << setw(8) << sax_us << " (" << dom_us / sax_us << "x)\n";
+  };
+  report("stream", all);
+  for (auto &entry : by_type) report(entry.first, entry.second);
+  return 0;
+}
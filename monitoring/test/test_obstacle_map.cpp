@@ -0,0 +1,204 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "obstacle_map.hpp"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const string& what) {
+  if (ok) return;
+  cout << "FAIL " << what << "\n";
+  failures++;
+}
+
+static EnemyShape shape(int id, vector<Vec> centers) {
+  EnemyShape result;
+  result.id = id;
+  result.centers = centers;
+  return result;
+}
+
+// the grid a full rasterization of every shape gives
+static OccupancyGrid reference(const vector<EnemyShape>& shapes, ObstacleParameters params) {
+  vector<vector<Vec>> obstacles, visible;
+  rasterizeShapes(shapes, params, obstacles, visible);
+  OccupancyGrid grid(params.node_distance, params.width, params.height);
+  grid.build(obstacles);
+  return grid;
+}
+
+static vector<size_t> difference(const OccupancyGrid& a, const OccupancyGrid& b) {
+  vector<size_t> cells;
+  for (int j = 0; j < a.getRows(); j++) {
+    for (int i = 0; i < a.getCols(); i++) {
+      if (a.blocked(i, j) != b.blocked(i, j)) cells.push_back(a.index(i, j));
+    }
+  }
+  return cells;
+}
+
+// applies the update, then compares the map with a full rasterization and its changed cells with the flips
+static void applyAndCompare(ObstacleMap& map, const vector<EnemyShape>& update, double radius, bool replace,
+                            const vector<EnemyShape>& all, const string& what) {
+  OccupancyGrid before = map.getGrid();
+  map.apply(update, radius, replace);
+  ObstacleParameters params;
+  params.radius = radius;
+  check(difference(map.getGrid(), reference(all, params)).empty(), what + ": grid matches a full rasterization");
+  check(map.getChanged() == difference(before, map.getGrid()), what + ": changed cells are the flipped ones");
+}
+
+static void testMap() {
+  ObstacleParameters params;
+  ObstacleMap map(params);
+  check(difference(map.getGrid(), reference({}, params)).empty(), "empty map has only the border blocked");
+
+  // two overlapping enemies, the first with a predicted sweep
+  EnemyShape first = shape(0, {Vec(300, 300), Vec(330, 300), Vec(360, 300)});
+  EnemyShape second = shape(1, {Vec(390, 310)});
+  applyAndCompare(map, {first, second}, params.radius, true, {first, second}, "both enemies");
+  check(map.getRasterized() == 2 && !map.getChanged().empty(), "both enemies rasterized");
+
+  // the overlap stays blocked while one of the two still covers it
+  EnemyShape moved = shape(1, {Vec(700, 450)});
+  applyAndCompare(map, {moved}, params.radius, false, {first, moved}, "second enemy moved away");
+  check(map.getRasterized() == 1, "only the named enemy rasterized");
+  int i, j;
+  map.getGrid().toCell(Vec(360, 300), i, j);
+  check(map.getGrid().blocked(i, j), "cell covered by both stays blocked");
+
+  // the same shape again flips nothing
+  map.apply({moved}, params.radius);
+  check(map.getChanged().empty() && map.getRasterized() == 1, "unchanged enemy flips no cell");
+
+  // moving away and back within one update leaves no change
+  EnemyShape away = shape(0, {Vec(100, 500)});
+  map.apply({away, first}, params.radius);
+  check(map.getChanged().empty() && map.getRasterized() == 2, "enemy moved away and back flips no cell");
+
+  // a different radius re-rasterizes the enemies the update does not name
+  applyAndCompare(map, {moved}, 60, false, {first, moved}, "larger radius");
+  check(map.getRasterized() == 2 && map.getRadius() == 60, "radius change rasterizes every enemy");
+
+  // replace drops the enemies the update does not name
+  applyAndCompare(map, {moved}, 60, true, {moved}, "replaced by one enemy");
+  map.getGrid().toCell(Vec(300, 300), i, j);
+  check(!map.getGrid().blocked(i, j), "dropped enemy's cells are free");
+
+  map.reset();
+  check(difference(map.getGrid(), reference({}, params)).empty() && map.getChanged().empty(), "reset clears the map");
+}
+
+static void testSync() {
+  ObstacleSync sync;
+  EnemyShape a = shape(0, {Vec(100, 100)}), b = shape(1, {Vec(500, 300)});
+  vector<EnemyShape> changed;
+  unsigned int sequence = 0, base = 0;
+
+  check(sync.delta({a, b}, 40, changed, sequence, base), "first update sent");
+  check(sequence == 1 && base == 0 && changed.size() == 2, "first update is full");
+  // nothing acknowledged yet, so every update stays full
+  check(sync.delta({a, b}, 40, changed, sequence, base) && sequence == 2 && base == 0, "full until acknowledged");
+  sync.acknowledge(2);
+  check(sync.getAcknowledged() == 2 && sync.getInFlight() == 0, "acknowledgement drops older updates in flight");
+  check(!sync.delta({a, b}, 40, changed, sequence, base), "up to date robot gets nothing");
+
+  EnemyShape nudged = shape(1, {Vec(500 + SHAPE_TOLERANCE / 2, 300)});
+  check(!sync.delta({a, nudged}, 40, changed, sequence, base), "move within the tolerance not sent");
+
+  EnemyShape b2 = shape(1, {Vec(530, 300)});
+  check(sync.delta({a, b2}, 40, changed, sequence, base), "moved enemy sent");
+  check(sequence == 3 && base == 2 && changed.size() == 1 && changed[0].id == 1, "delta names only the moved enemy");
+
+  // unacknowledged enemies are sent again, so the delta applies on top of either version
+  EnemyShape a2 = shape(0, {Vec(130, 100)});
+  check(sync.delta({a2, b2}, 40, changed, sequence, base), "second move sent");
+  check(sequence == 4 && base == 2 && changed.size() == 2, "delta repeats the enemy still in flight");
+
+  sync.acknowledge(4);
+  sync.acknowledge(3);
+  check(sync.getAcknowledged() == 4, "late acknowledgement of an older update ignored");
+  sync.acknowledge(99);
+  check(sync.getAcknowledged() == 4, "unknown sequence ignored");
+
+  check(sync.delta({a2, b2}, 60, changed, sequence, base) && base == 0 && changed.size() == 2, "radius change is full");
+  sync.acknowledge(sequence);
+  check(sync.delta({a2}, 60, changed, sequence, base) && base == 0 && changed.size() == 1, "enemy count change is full");
+  sync.acknowledge(sequence);
+
+  // the robot lost its map
+  sync.acknowledge(0);
+  check(sync.getAcknowledged() == 0, "acknowledging 0 resets");
+  check(sync.delta({a2}, 60, changed, sequence, base) && base == 0, "update after a reset is full");
+  sync.acknowledge(sequence);
+
+  // a robot that stops acknowledging gets everything again
+  Vec position(100, 500);
+  for (size_t k = 0; k < MAX_IN_FLIGHT; k++) {
+    position.x += 10;
+    check(sync.delta({shape(0, {position})}, 60, changed, sequence, base) && base != 0, "delta while in flight");
+  }
+  position.x += 10;
+  check(sync.delta({shape(0, {position})}, 60, changed, sequence, base) && base == 0, "full update once too many are in flight");
+}
+
+// the robot's side of the exchange, as the controller applies updates
+struct Robot {
+    ObstacleMap map{ObstacleParameters()};
+    unsigned int sequence = 0;
+
+    // the acknowledgement sent back
+    unsigned int receive(const vector<EnemyShape>& shapes, double radius, unsigned int update, unsigned int base) {
+      if (base > sequence) return 0;
+      map.apply(shapes, radius, base == 0);
+      sequence = update;
+      return update;
+    }
+};
+
+static void testRecovery() {
+  ObstacleSync sync;
+  Robot robot;
+  vector<EnemyShape> changed;
+  unsigned int sequence, base;
+  vector<EnemyShape> world = {shape(0, {Vec(200, 200)}), shape(1, {Vec(600, 400)}), shape(2, {Vec(450, 100)})};
+
+  sync.delta(world, 40, changed, sequence, base);
+  sync.acknowledge(robot.receive(changed, 40, sequence, base));
+
+  // an update is lost, the next one still brings the robot up to date
+  world[0].centers[0] = Vec(260, 220);
+  sync.delta(world, 40, changed, sequence, base);
+  world[1].centers[0] = Vec(560, 380);
+  sync.delta(world, 40, changed, sequence, base);
+  sync.acknowledge(robot.receive(changed, 40, sequence, base));
+  ObstacleParameters params;
+  check(difference(robot.map.getGrid(), reference(world, params)).empty(), "robot recovers from a lost update");
+
+  // a restarted robot cannot apply a delta, its 0 acknowledgement brings a full update
+  Robot restarted;
+  world[2].centers[0] = Vec(420, 160);
+  check(sync.delta(world, 40, changed, sequence, base) && base != 0, "delta for the old robot");
+  unsigned int ack = restarted.receive(changed, 40, sequence, base);
+  check(ack == 0, "restarted robot refuses a delta on a version it never had");
+  sync.acknowledge(ack);
+  check(sync.delta(world, 40, changed, sequence, base) && base == 0, "full update after the refusal");
+  sync.acknowledge(restarted.receive(changed, 40, sequence, base));
+  check(difference(restarted.map.getGrid(), reference(world, params)).empty(), "restarted robot has the whole map");
+  check(!sync.delta(world, 40, changed, sequence, base), "restarted robot up to date");
+}
+
+int main() {
+  testMap();
+  testSync();
+  testRecovery();
+  if (failures) {
+    cout << failures << " obstacle map checks failed\n";
+    return 1;
+  }
+  cout << "obstacle map ok\n";
+  return 0;
+}
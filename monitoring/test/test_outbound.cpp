@@ -0,0 +1,133 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+
+#include "outbound.hpp"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const string& what) {
+  if (ok) return;
+  cout << "FAIL " << what << "\n";
+  failures++;
+}
+
+// what one flush handed to the connection
+struct Sink {
+    vector<string> payloads;
+    bool accept = true;
+
+    function<bool(const OutboundMessage&)> send() {
+      return [this](const OutboundMessage& message) {
+        payloads.push_back(message.payload);
+        return accept;
+      };
+    }
+};
+
+static void testCoalescing() {
+  OutboundQueue queue;
+  Sink sink;
+  queue.setLatest(OUTBOUND_POSE, {"pose 1", false});
+  queue.setLatest(OUTBOUND_POSE, {"pose 2", false});
+  queue.setLatest(OUTBOUND_POSE, {"pose 3", true});
+  queue.setLatest(OUTBOUND_ASTAR_PATH, {"path", false});
+  check(queue.getCoalesced() == 2, "two superseded poses coalesced");
+  check(queue.getDepth() == 2, "one message waiting per slot");
+
+  queue.push({"event 1", false});
+  queue.push({"event 2", false});
+  check(queue.flush(sink.send(), false) < 0, "nothing waits after an unlimited flush");
+  // events first in their order, then the slots in slot order
+  check(sink.payloads == vector<string>({"event 1", "event 2", "pose 3", "path"}), "flush order and newest pose");
+  check(queue.getSent() == 4 && queue.getDepth() == 0, "everything sent");
+
+  sink.payloads.clear();
+  queue.flush(sink.send(), false);
+  check(sink.payloads.empty(), "a sent slot is not sent again");
+
+  queue.setLatest(OUTBOUND_SLOT_COUNT, {"nowhere", false});
+  check(queue.getDepth() == 0, "an unknown slot is ignored");
+}
+
+static void testStates() {
+  OutboundQueue queue;
+  Sink sink;
+  check(queue.pushState(OUTBOUND_FINISHED, {"finished 1", false}), "first state queued");
+  check(!queue.pushState(OUTBOUND_FINISHED, {"finished 1", false}), "repeated state dropped");
+  check(queue.getDeduplicated() == 1, "one state deduplicated");
+  check(queue.pushState(OUTBOUND_FINISHED, {"finished 2", false}), "changed state queued");
+
+  queue.clearState(OUTBOUND_FINISHED);
+  check(queue.pushState(OUTBOUND_FINISHED, {"finished 2", false}), "state queued again after clearState");
+
+  // a new connection has not seen any state
+  queue.reset();
+  check(queue.getDepth() == 0, "reset drops what was queued");
+  check(queue.pushState(OUTBOUND_FINISHED, {"finished 2", false}), "state queued again after reset");
+  queue.flush(sink.send(), false);
+  check(sink.payloads == vector<string>({"finished 2"}), "only the state after reset is sent");
+  check(!queue.pushState(OUTBOUND_STATE_COUNT, {"nowhere", false}), "an unknown state is refused");
+}
+
+static void testRate() {
+  // 20 a second, one slot message per 50 ms
+  OutboundQueue queue(20);
+  Sink sink;
+  queue.setLatest(OUTBOUND_POSE, {"pose 1", false});
+  check(queue.flush(sink.send(), false) < 0, "first pose goes at once");
+  check(sink.payloads.size() == 1, "first pose sent");
+
+  queue.setLatest(OUTBOUND_POSE, {"pose 2", false});
+  queue.push({"event", false});
+  double wait = queue.flush(sink.send(), false);
+  check(wait > 0 && wait <= 0.05, "second pose waits for the rest of the interval");
+  check(sink.payloads == vector<string>({"pose 1", "event"}), "events are not rate limited");
+  check(queue.getDeferred() == 1 && queue.getDepth() == 1, "pose deferred and still waiting");
+
+  this_thread::sleep_for(chrono::milliseconds(60));
+  check(queue.flush(sink.send(), true) == OUTBOUND_RETRY, "a congested connection retries shortly");
+  check(queue.getDeferred() == 2 && sink.payloads.size() == 2, "nothing sent while congested");
+  check(queue.flush(sink.send(), false) < 0, "nothing waits once the pose went");
+  check(sink.payloads.back() == "pose 2", "deferred pose sent after the interval");
+}
+
+static void testDropped() {
+  OutboundQueue queue;
+  Sink sink;
+  size_t accepted = 0;
+  for (size_t k = 0; k < OUTBOUND_CAPACITY + 3; k++) accepted += queue.push({to_string(k), false});
+  check(accepted == OUTBOUND_CAPACITY && queue.getDropped() == 3, "events beyond the ring are dropped");
+  check(queue.getDepth() == OUTBOUND_CAPACITY, "depth counts the full ring");
+
+  sink.accept = false;
+  queue.flush(sink.send(), false);
+  check(queue.getSent() == 0 && queue.getDropped() == 3 + OUTBOUND_CAPACITY, "failed sends are dropped");
+  check(queue.getMaxDepth() == OUTBOUND_CAPACITY, "max depth seen by the flush");
+}
+
+static void testSchedule() {
+  OutboundQueue queue;
+  Sink sink;
+  check(queue.schedule(), "first schedule posts a flush");
+  check(!queue.schedule(), "pending flush is not posted twice");
+  queue.flush(sink.send(), false);
+  check(queue.schedule(), "schedule after the flush posts again");
+}
+
+int main() {
+  testCoalescing();
+  testStates();
+  testRate();
+  testDropped();
+  testSchedule();
+  if (failures) {
+    cout << failures << " outbound checks failed\n";
+    return 1;
+  }
+  cout << "outbound ok\n";
+  return 0;
+}
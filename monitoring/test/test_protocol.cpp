@@ -0,0 +1,109 @@
+#include <iostream>
+#include <cmath>
+
+#include "protocol.hpp"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const string& what) {
+  if (ok) return;
+  cout << "FAIL " << what << "\n";
+  failures++;
+}
+
+static bool near(double a, double b, double tolerance) {
+  return fabs(a - b) <= tolerance;
+}
+
+static void testPose() {
+  PoseFrame pose;
+  pose.x = 412.5;
+  pose.y = -37.25;
+  pose.dir = 1.5;
+  pose.target_x = 600;
+  pose.target_y = 300;
+  pose.cross_track = 2.75;
+  pose.avoidance_us = 18;
+  pose.validity_us = 3.5;
+  pose.snapshot_us = 0.25;
+  pose.step = 123456;
+
+  string frame = encodePose(pose);
+  check(frame.size() == POSE_FRAME_SIZE, "pose frame size");
+  check(frameType(frame) == FRAME_POSE, "pose frame type");
+
+  PoseFrame decoded;
+  check(decodePose(frame, decoded), "pose round trip");
+  check(decoded.x == pose.x && decoded.y == pose.y && decoded.dir == pose.dir, "pose position");
+  check(decoded.target_x == pose.target_x && decoded.target_y == pose.target_y, "pose target");
+  check(decoded.cross_track == pose.cross_track && decoded.avoidance_us == pose.avoidance_us &&
+        decoded.validity_us == pose.validity_us && decoded.snapshot_us == pose.snapshot_us, "pose timings");
+  check(decoded.step == pose.step, "pose step");
+
+  check(!decodePose(frame.substr(0, frame.size() - 1), decoded), "truncated pose");
+  check(!decodePose(frame.substr(0, FRAME_HEADER_SIZE), decoded), "pose header only");
+  check(!decodePose(frame + '\0', decoded), "pose with a trailing byte");
+
+  string magic = frame;
+  magic[0] = static_cast<char>(FRAME_MAGIC ^ 0xFF);
+  check(frameType(magic) == -1 && !decodePose(magic, decoded), "pose with a wrong magic");
+  string version = frame;
+  version[1] = static_cast<char>(PROTOCOL_VERSION + 1);
+  check(!decodePose(version, decoded), "pose of another version");
+
+  vector<Vec> path;
+  check(!decodePath(frame, path), "pose decoded as a path");
+}
+
+static void testPath(FrameType type) {
+  string name = frameName(type);
+  vector<Vec> path;
+  for (int k = 0; k < 50; k++) path.push_back(Vec(30 * k + 0.37, 300 - 12.5 * k - 0.01 * k * k));
+  path.push_back(Vec(-20, 900.5));
+
+  string frame = encodePath(type, path);
+  check(frameType(frame) == type, name + " frame type");
+
+  vector<Vec> decoded;
+  check(decodePath(frame, decoded), name + " round trip");
+  check(decoded.size() == path.size(), name + " point count");
+  bool same = decoded.size() == path.size();
+  for (size_t k = 0; same && k < path.size(); k++) {
+    same = near(decoded[k].x, path[k].x, 0.5 / PATH_RESOLUTION) && near(decoded[k].y, path[k].y, 0.5 / PATH_RESOLUTION);
+  }
+  check(same, name + " points within the resolution");
+
+  vector<Vec> empty;
+  check(decodePath(encodePath(type, vector<Vec>()), empty) && empty.empty(), name + " empty path");
+
+  for (size_t cut = FRAME_HEADER_SIZE; cut < frame.size(); cut++) {
+    if (decodePath(frame.substr(0, cut), decoded)) {
+      check(false, name + " truncated to " + to_string(cut) + " bytes");
+      break;
+    }
+  }
+  check(!decodePath(frame.substr(0, 2), decoded), name + " without a header");
+  check(!decodePath(frame + '\0', decoded), name + " with a trailing byte");
+  check(!decodePath(frame + frame, decoded), name + " followed by another frame");
+
+  string magic = frame;
+  magic[0] = static_cast<char>(FRAME_MAGIC ^ 0xFF);
+  check(!decodePath(magic, decoded), name + " with a wrong magic");
+
+  PoseFrame pose;
+  check(!decodePose(frame, pose), name + " decoded as a pose");
+}
+
+int main() {
+  testPose();
+  testPath(FRAME_ASTAR_PATH);
+  testPath(FRAME_BEZIER_PATH);
+  if (failures) {
+    cout << failures << " protocol checks failed\n";
+    return 1;
+  }
+  cout << "protocol ok\n";
+  return 0;
+}
@@ -0,0 +1,190 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "replan_policy.hpp"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const string& what) {
+  if (ok) return;
+  cout << "FAIL " << what << "\n";
+  failures++;
+}
+
+// the corners joined by samples step apart, like a smoothed path
+static vector<Vec> samples(const vector<Vec>& corners, double step) {
+  vector<Vec> path{corners[0]};
+  for (size_t k = 1; k < corners.size(); k++) {
+    Vec delta = corners[k] - corners[k-1];
+    int parts = max(1, static_cast<int>(round(delta.len() / step)));
+    for (int p = 1; p <= parts; p++) path.push_back(corners[k-1] + delta * (static_cast<double>(p) / parts));
+  }
+  return path;
+}
+
+static WorldSnapshot world(Vec robot, const vector<Vec>& enemies, shared_ptr<const OccupancyGrid> grid) {
+  WorldSnapshot snapshot;
+  snapshot.robot = robot;
+  snapshot.enemies = make_shared<const vector<Vec>>(enemies);
+  snapshot.grid = grid;
+  return snapshot;
+}
+
+static chrono::steady_clock::time_point at(chrono::steady_clock::time_point start, double seconds) {
+  return start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+}
+
+static size_t cellAt(const OccupancyGrid& grid, Vec point) {
+  int i, j;
+  grid.toCell(point, i, j);
+  return grid.index(i, j);
+}
+
+static bool decided(ReplanDecision decision, int reason, bool local) {
+  return decision.reason == reason && decision.local == local;
+}
+
+// the numbers below assume these, not whatever parameter.json holds
+static void setParameters(GlobalData& global) {
+  global.replan_interval = 0.5;
+  global.replan_clearance = 30;
+  global.replan_improvement = 0.1;
+  global.neighbor_distance = 150;
+  global.robot_radius = 40;
+}
+
+static void testNoPath(GlobalData& global) {
+  ReplanPolicy policy(global);
+  auto grid = make_shared<const OccupancyGrid>(30, 900, 600);
+  auto now = chrono::steady_clock::now();
+  check(policy.check(world(Vec(60, 300), {}, grid), 0, now).reason == -1 && policy.getChecks() == 0, "no path, no check");
+
+  policy.setPath(samples({Vec(60, 300), Vec(840, 300)}, 30), *grid);
+  check(policy.check(world(Vec(840, 300), {}, grid), 26, now).reason == -1 && policy.getChecks() == 0, "finished path not checked");
+  check(strcmp(replanReasonName(-1), "start") == 0 && strcmp(replanReasonName(REPLAN_BLOCKED), "blocked") == 0, "reason names");
+}
+
+static void testBlocked(GlobalData& global) {
+  ReplanPolicy policy(global);
+  auto grid = make_shared<const OccupancyGrid>(30, 900, 600);
+  vector<Vec> path = samples({Vec(60, 300), Vec(840, 300)}, 30);
+  policy.setPath(path, *grid);
+  auto start = chrono::steady_clock::now();
+
+  vector<Vec> far{Vec(450, 550)};
+  check(policy.check(world(path[0], far, grid), 0, start).reason == -1, "clear path kept");
+  check(policy.getGridWalks() == 1, "first check walks the grid");
+  policy.check(world(path[0], far, grid), 0, at(start, 0.1));
+  check(policy.getGridWalks() == 1, "unchanged grid not walked again");
+
+  // an enemy circle across the path
+  vector<Vec> across{Vec(450, 305)};
+  check(decided(policy.check(world(path[0], across, grid), 0, at(start, 0.2)), REPLAN_BLOCKED, true), "enemy on the path blocks");
+  check(policy.check(world(path[0], across, grid), 0, at(start, 0.4)).reason == -1, "blocked replan throttled");
+  check(policy.getSkipped(REPLAN_BLOCKED) == 1, "throttled replan counted as skipped");
+  check(decided(policy.check(world(path[0], across, grid), 0, at(start, 0.8)), REPLAN_BLOCKED, true), "blocked again after the interval");
+  check(policy.getTriggered(REPLAN_BLOCKED) == 2, "two blocked replans");
+
+  // the part of the path already walked does not count
+  check(policy.check(world(path[16], across, grid), 16, at(start, 2)).reason == -1, "enemy behind the robot ignored");
+
+  // a blocked cell away from the path does not make the grid worth walking
+  auto aside = make_shared<OccupancyGrid>(*grid);
+  int i, j;
+  aside->toCell(Vec(450, 90), i, j);
+  aside->set(i, j, true);
+  policy.invalidate({cellAt(*aside, Vec(450, 90))}, *aside);
+  size_t walks = policy.getGridWalks();
+  check(policy.check(world(path[0], far, aside), 0, at(start, 3)).reason == -1, "cell off the path keeps it");
+  check(policy.getGridWalks() == walks, "cell off the path skips the grid walk");
+
+  // one next to it does
+  auto onto = make_shared<OccupancyGrid>(*aside);
+  onto->toCell(Vec(450, 300), i, j);
+  onto->set(i, j, true);
+  policy.invalidate({cellAt(*onto, Vec(450, 300))}, *onto);
+  check(decided(policy.check(world(path[0], far, onto), 0, at(start, 4)), REPLAN_BLOCKED, true), "cell on the path blocks");
+  check(policy.getGridWalks() == walks + 1, "cell on the path walks the grid");
+}
+
+static void testClearance(GlobalData& global) {
+  ReplanPolicy policy(global);
+  auto grid = make_shared<const OccupancyGrid>(30, 900, 600);
+  vector<Vec> path = samples({Vec(60, 300), Vec(840, 300)}, 30);
+  policy.setPath(path, *grid);
+  auto start = chrono::steady_clock::now();
+
+  // the plan's own clearance is taken on the first check
+  check(policy.check(world(path[0], {Vec(150, 550)}, grid), 0, start).reason == -1, "wide clearance kept");
+  // beyond the horizon an enemy is left to the grid
+  check(policy.check(world(path[0], {Vec(450, 325)}, grid), 0, at(start, 0.1)).reason == -1, "enemy beyond the horizon ignored");
+
+  // closer than the minimum clearance, its circle still off the path
+  check(decided(policy.check(world(path[0], {Vec(150, 329)}, grid), 0, at(start, 1)), REPLAN_CLEARANCE, false), "clearance drop replans");
+  check(policy.check(world(path[0], {Vec(150, 327)}, grid), 0, at(start, 1.1)).reason == -1, "small further drop kept");
+  check(policy.getSkipped(REPLAN_CLEARANCE) == 1, "small drop counted as skipped");
+  check(policy.check(world(path[0], {Vec(150, 322)}, grid), 0, at(start, 1.2)).reason == -1, "large drop throttled");
+  check(decided(policy.check(world(path[0], {Vec(150, 322)}, grid), 0, at(start, 2)), REPLAN_CLEARANCE, false), "large drop replans after the interval");
+  check(policy.getTriggered(REPLAN_CLEARANCE) == 2, "two clearance replans");
+
+  // a new path starts from its own clearance again
+  policy.setPath(path, *grid);
+  check(policy.check(world(path[0], {Vec(150, 322)}, grid), 0, at(start, 4)).reason == -1, "new path takes the current clearance");
+}
+
+static void testImprovement(GlobalData& global) {
+  ReplanPolicy policy(global);
+  // a detour around a cell that is then freed
+  auto grid = make_shared<OccupancyGrid>(30, 900, 600);
+  int i, j;
+  grid->toCell(Vec(450, 300), i, j);
+  grid->set(i, j, true);
+  vector<Vec> path = samples({Vec(60, 300), Vec(450, 60), Vec(840, 300)}, 30);
+  policy.setPath(path, *grid);
+  auto start = chrono::steady_clock::now();
+  vector<Vec> far{Vec(450, 550)};
+  check(policy.check(world(path[0], far, grid), 0, start).reason == -1, "detour kept while the cell is blocked");
+
+  auto freed = make_shared<OccupancyGrid>(*grid);
+  freed->set(i, j, false);
+  policy.invalidate({cellAt(*freed, Vec(450, 300))}, *freed);
+  check(decided(policy.check(world(path[0], far, freed), 0, at(start, 0.1)), REPLAN_IMPROVEMENT, false), "shortcut replans");
+  check(policy.check(world(path[0], far, freed), 0, at(start, 0.2)).reason == -1, "shortcut replans once");
+
+  // another shortcut right after the replan waits for the interval
+  policy.invalidate({cellAt(*freed, Vec(450, 270))}, *freed);
+  check(policy.check(world(path[0], far, freed), 0, at(start, 0.3)).reason == -1, "shortcut throttled");
+  check(decided(policy.check(world(path[0], far, freed), 0, at(start, 1)), REPLAN_IMPROVEMENT, false), "throttled shortcut looked at again");
+  check(policy.getTriggered(REPLAN_IMPROVEMENT) == 2 && policy.getSkipped(REPLAN_IMPROVEMENT) == 1, "improvement counts");
+
+  // a freed cell next to the path saves too little
+  auto near = make_shared<OccupancyGrid>(*freed);
+  near->toCell(Vec(450, 120), i, j);
+  near->set(i, j, true);
+  policy.invalidate({cellAt(*near, Vec(450, 120))}, *near);
+  auto cleared = make_shared<OccupancyGrid>(*near);
+  cleared->set(i, j, false);
+  policy.invalidate({cellAt(*cleared, Vec(450, 120))}, *cleared);
+  check(policy.check(world(path[0], far, cleared), 0, at(start, 3)).reason == -1, "small shortcut kept");
+  check(policy.getSkipped(REPLAN_IMPROVEMENT) == 2, "small shortcut counted as skipped");
+}
+
+int main() {
+  // run from monitoring/
+  GlobalData global("../");
+  setParameters(global);
+  testNoPath(global);
+  testBlocked(global);
+  testClearance(global);
+  testImprovement(global);
+  if (failures) {
+    cout << failures << " replan checks failed\n";
+    return 1;
+  }
+  cout << "replan ok\n";
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "spsc_ring.hpp"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const string& what) {
+  if (ok) return;
+  cout << "FAIL " << what << "\n";
+  failures++;
+}
+
+static void testEmptyAndFull() {
+  SpscRing<int, 4> ring;
+  int item = -1;
+  check(ring.size() == 0 && !ring.pop(item) && item == -1, "new ring is empty");
+
+  for (int k = 0; k < 4; k++) check(ring.push(int(k)), "push " + to_string(k) + " into a ring with room");
+  check(ring.size() == 4, "full ring size");
+  check(!ring.push(99), "push into a full ring");
+  check(ring.size() == 4, "rejected push leaves the size");
+
+  check(ring.pop(item) && item == 0, "pop from a full ring");
+  check(ring.push(4), "push after a pop frees a slot");
+  check(!ring.push(5), "ring full again");
+
+  for (int k = 1; k <= 4; k++) check(ring.pop(item) && item == k, "pop " + to_string(k) + " in order");
+  check(ring.size() == 0 && !ring.pop(item), "drained ring is empty");
+}
+
+static void testWrap() {
+  // the indices only grow, every slot is reused many times over
+  SpscRing<string, 8> ring;
+  int pushed = 0, popped = 0;
+  bool ordered = true;
+  for (int round = 0; round < 100; round++) {
+    int batch = 1 + round % 8;
+    for (int k = 0; k < batch; k++) {
+      if (!ring.push(to_string(pushed))) {
+        check(false, "push within capacity on round " + to_string(round));
+        return;
+      }
+      pushed++;
+    }
+    string item;
+    for (int k = 0; k < batch; k++) {
+      ordered = ordered && ring.pop(item) && item == to_string(popped);
+      popped++;
+    }
+  }
+  check(ordered, "items keep their order across wraps");
+  check(pushed > 8 * 8 && ring.size() == 0, "wrapped ring ends empty");
+}
+
+static void testThreads() {
+  SpscRing<int, 16> ring;
+  const int count = 200000;
+  thread producer([&]() {
+    for (int k = 0; k < count; k++) {
+      while (!ring.push(int(k))) this_thread::yield();
+    }
+  });
+  int expected = 0, item;
+  bool ordered = true;
+  while (expected < count) {
+    if (!ring.pop(item)) {
+      this_thread::yield();
+      continue;
+    }
+    ordered = ordered && item == expected;
+    expected++;
+  }
+  producer.join();
+  check(ordered, "consumer sees the producer's order");
+  check(ring.size() == 0 && !ring.pop(item), "ring empty after both sides finished");
+}
+
+int main() {
+  testEmptyAndFull();
+  testWrap();
+  testThreads();
+  if (failures) {
+    cout << failures << " ring checks failed\n";
+    return 1;
+  }
+  cout << "ring ok\n";
+  return 0;
+}
@@ -1,4 +1,6 @@
 #include "controller.hpp"
+#include "outbound.hpp"
+#include "message.hpp"
 
 #include <websocketpp/config/asio_no_tls.hpp>
 #include <websocketpp/server.hpp>
@@ -8,6 +10,7 @@
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <atomic>
 
 using namespace std;
 
@@ -25,10 +28,21 @@ GlobalData *global = new GlobalData("../../../");
 Controller *controller = new Controller(global);
 
 bool isRunning = false;
+ProtocolStats protocol_stats;
+
+// set by the monitor's hello on the server thread, JSON until then
+atomic<bool> binary_protocol{false};
+// the main thread queues, only the server thread touches the connection
+OutboundQueue *outbound = new OutboundQueue(global->telemetry_rate);
+bool flush_timer = false;
 
 void on_open(server*, connection_hdl);
 void on_close(server*, connection_hdl);
 void on_message(server*, connection_hdl, server::message_ptr);
+void postCommand(ControllerCommand);
+void onCommand(const ControllerCommand&);
+void queueOutbound();
+void flushOutbound();
 
 int main(int argc, char** argv) {
   ws_server->set_open_handler(bind(on_open, ws_server, ::_1));
@@ -37,6 +51,7 @@ int main(int argc, char** argv) {
   ws_server->set_error_channels(websocketpp::log::elevel::none);
   ws_server->set_access_channels(websocketpp::log::alevel::none);
   ws_server->set_message_handler(bind(on_message, ws_server, ::_1, ::_2));
+  controller->setCommandHandler(onCommand);
 
   thread server_thread([&]() {
     while (true) {
@@ -55,25 +70,22 @@ int main(int argc, char** argv) {
   thread main_thread([&]() {
     while (true) {
       if (isRunning) {
-        try {
-          json data;
-          data["type"] = "position";
-          data["value"]["x"] = controller->getPosition().x;
-          data["value"]["y"] = controller->getPosition().y;
-          data["value"]["dir"] = controller->getDirInRadian();
-          ws_server->send(ws_conn, to_string(data), websocketpp::frame::opcode::text);
-        } catch(...) {
-          cout << "failed send data" << endl;
-        }
+        PoseRecord pose = controller->getPose();
+        bool binary = binary_protocol;
+        outbound->setLatest(OUTBOUND_POSE, {encodePoseMessage(makePoseFrame(pose), binary, false, protocol_stats), binary});
 
-        if (controller->getIsFinished()) {
+        // reported every step until the next target arrives, the queue only sends it when it changed
+        if (pose.finished) {
           json data;
           data["type"] = "finished";
           data["name"] = controller->getName();
-          data["target"]["x"] = controller->getTarget().x;
-          data["target"]["y"] = controller->getTarget().y;
-          ws_server->send(ws_conn, to_string(data), websocketpp::frame::opcode::text);
+          data["target"]["x"] = pose.target.x;
+          data["target"]["y"] = pose.target.y;
+          outbound->pushState(OUTBOUND_FINISHED, {to_string(data), false});
+        } else {
+          outbound->clearState(OUTBOUND_FINISHED);
         }
+        queueOutbound();
       }
       controller->process();
     }
@@ -87,35 +99,93 @@ int main(int argc, char** argv) {
 
 void on_open(server* ws_server, connection_hdl hdl) {
   cout << "connection open: " << controller->getName() << endl;
+  binary_protocol = false;
+  outbound->reset();
   ws_conn = hdl;
 }
 
 void on_close(server* ws_server, connection_hdl hdl) {
   cout << "connection close: " << controller->getName() << endl;
+  binary_protocol = false;
+  outbound->reset();
 }
 
 void on_message(server* ws_server, connection_hdl hdl, server::message_ptr msg) {
-  json data = json::parse(msg->get_payload());
-  string type = data["type"].template get<string>();
-  if (type == "run") {
-    string value = data["value"].template get<string>();
-    if (value == "start") {
-      isRunning = true;
-      controller->run(true);
-      Vec target = Vec(
-        data["target"]["x"].template get<double>(),
-        data["target"]["y"].template get<double>()
-      );
-      controller->setTarget(target);
-    } else if (value == "stop") {
-      isRunning = false;
-      controller->run(false);
+  // only the asio thread reads messages, the decoded one is reused
+  static Message message;
+  if (!decodeMessage(msg->get_payload(), message)) {
+    cout << controller->getName() << " malformed message" << endl;
+    return;
+  }
+  ControllerCommand command;
+  command.time = chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+  if (message.type == MESSAGE_HELLO) {
+    // binary frames only when the monitor speaks this protocol version
+    bool binary = message.protocol == PROTOCOL_VERSION && message.binary;
+    binary_protocol = binary;
+    json reply;
+    reply["type"] = "hello";
+    reply["protocol"] = PROTOCOL_VERSION;
+    reply["format"] = binary ? "binary" : "json";
+    ws_server->send(hdl, to_string(reply), websocketpp::frame::opcode::text);
+  } else if (message.type == MESSAGE_RUN) {
+    if (message.start) {
+      command.type = COMMAND_START;
+      postCommand(move(command));
+      command = ControllerCommand();
+      command.type = COMMAND_SET_TARGET;
+      command.target = message.target;
+      postCommand(move(command));
+    } else {
+      command.type = COMMAND_STOP;
+      postCommand(move(command));
     }
-  } else if (type == "target") {
-    Vec target = Vec(
-      data["value"]["x"].template get<double>(),
-      data["value"]["y"].template get<double>()
-    );
-    controller->setTarget(target);
+  } else if (message.type == MESSAGE_TARGET) {
+    command.type = COMMAND_SET_TARGET;
+    command.target = message.target;
+    postCommand(move(command));
+  } else if (message.type == MESSAGE_NEIGHBORS) {
+    command.type = COMMAND_SET_NEIGHBORS;
+    command.points = message.points;
+    postCommand(move(command));
+  }
+}
+
+void postCommand(ControllerCommand command) {
+  if (!controller->post(move(command))) cout << controller->getName() << " command queue full" << endl;
+}
+
+void onCommand(const ControllerCommand& command) {
+  // isRunning is only read and written on the main thread
+  if (command.type == COMMAND_START) isRunning = true;
+  else if (command.type == COMMAND_STOP) {
+    isRunning = false;
+    cout << controller->getName() << " protocol\n" << protocol_stats.report() << outbound->report() << flush;
+  }
+}
+
+void queueOutbound() {
+  if (outbound->schedule()) ws_server->get_io_service().post(flushOutbound);
+}
+
+void flushOutbound() {
+  websocketpp::lib::error_code error;
+  server::connection_ptr connection = ws_server->get_con_from_hdl(ws_conn, error);
+  if (error) {
+    // nobody to send to, the next connection starts empty anyway
+    outbound->reset();
+    return;
   }
-}
\ No newline at end of file
+  // a slow monitor keeps only the newest pose waiting
+  bool congested = connection->get_buffered_amount() > OUTBOUND_BUFFER_LIMIT;
+  double wait = outbound->flush([&](const OutboundMessage& message) {
+    return !connection->send(message.payload, message.binary ? websocketpp::frame::opcode::binary : websocketpp::frame::opcode::text);
+  }, congested);
+  if (wait >= 0 && !flush_timer) {
+    flush_timer = true;
+    ws_server->set_timer(static_cast<long>(wait * 1000) + 1, [](const websocketpp::lib::error_code&) {
+      flush_timer = false;
+      flushOutbound();
+    });
+  }
+}
@@ -1,5 +1,11 @@
 #include "controller.hpp"
+#include "outbound.hpp"
+#include "message.hpp"
 #include "path_generator.hpp"
+#include "replan_policy.hpp"
+#include "plan_worker.hpp"
+#include "world_model.hpp"
+#include "tracker.hpp"
 
 #include <websocketpp/config/asio_no_tls.hpp>
 #include <websocketpp/server.hpp>
@@ -9,6 +15,7 @@
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <atomic>
 
 using namespace std;
 
@@ -24,14 +31,47 @@ connection_hdl ws_conn;
 
 GlobalData *global = new GlobalData("../../../");
 Controller *controller = new Controller(global);
-PathGenerator *generator = new PathGenerator(global);
+PlanWorker *planner = new PlanWorker(*global);
+ReplanPolicy *policy = new ReplanPolicy(*global);
+// versions of the world shared with the planning worker, the only copy of the robot, ball,
+// enemies and obstacles after startup, global keeps the parameters and the starting scene
+WorldModel *world = new WorldModel(global);
+// the enemies' cells, updated by the monitor's deltas and the live positions
+ObstacleMap *obstacle_map = new ObstacleMap(makeObstacleParameters(global));
 
+// everything below is only touched by the main thread, the server thread posts commands
 bool isRunning = false;
 int path_index = -1;
+// last obstacle update applied
+unsigned int obstacle_sequence = 0;
+
+// plans of an older start or stop are ignored when they finish
+int run_generation = 0;
+// the plan the controller follows
+shared_ptr<const PlanSnapshot> current_plan;
+double run_start = 0, planned_time = 0;
+double validity_us = 0;
+ProtocolStats protocol_stats;
+
+// set by the monitor's hello on the server thread, JSON until then
+atomic<bool> binary_protocol{false};
+// the main thread queues, only the server thread touches the connection
+OutboundQueue *outbound = new OutboundQueue(global->telemetry_rate);
+bool flush_timer = false;
 
 void on_open(server*, connection_hdl);
 void on_close(server*, connection_hdl);
 void on_message(server*, connection_hdl, server::message_ptr);
+void postCommand(ControllerCommand);
+void onCommand(const ControllerCommand&);
+void sendPose(const PoseRecord&);
+void sendPath(const PlanSnapshot&);
+void queueOutbound();
+void flushOutbound();
+PlanRequest makeRequest();
+void adoptPlan();
+void checkPath();
+void publishObstacles();
 
 int main(int argc, char** argv) {
   ws_server->set_open_handler(bind(on_open, ws_server, ::_1));
@@ -40,6 +80,10 @@ int main(int argc, char** argv) {
   ws_server->set_error_channels(websocketpp::log::elevel::none);
   ws_server->set_access_channels(websocketpp::log::alevel::none);
   ws_server->set_message_handler(bind(on_message, ws_server, ::_1, ::_2));
+  controller->setCommandHandler(onCommand);
+  // same cells as the world's first grid, so the first update's changes are exact
+  obstacle_map->apply(trackedShapes(global, *world->load()->enemies, EnemyTracker::now()), global->robot_radius);
+  publishObstacles();
 
   thread server_thread([&]() {
     while (true) {
@@ -57,33 +101,27 @@ int main(int argc, char** argv) {
   });
   thread main_thread([&]() {
     while (true) {
+      adoptPlan();
       if (isRunning) {
-        try {
-          json data;
-          data["type"] = "position";
-          data["value"]["x"] = controller->getPosition().x;
-          data["value"]["y"] = controller->getPosition().y;
-          data["value"]["dir"] = controller->getDirInRadian();
-          data["value"]["target"]["x"] = controller->getTarget().x;
-          data["value"]["target"]["y"] = controller->getTarget().y;
-          ws_server->send(ws_conn, to_string(data), websocketpp::frame::opcode::text);
-        } catch(...) {
-          cout << "failed send data" << endl;
-        }
-        global->robot = controller->getPosition();
+        PoseRecord pose = controller->getPose();
+        sendPose(pose);
+        world->setRobot(pose.position);
+        // the controller follows the path, its progress is where replans and validation start
+        path_index = controller->getPathIndex();
         if (controller->getIsFinished()) {
-          while (path_index == -1 || (global->robot - global->bezier_path[path_index]).len() < global->robot_radius/2) {
-            path_index++;
-            if ((size_t)path_index == global->bezier_path.size()) {
-              isRunning = false;
-              controller->run(false);
-              json data;
-              data["type"] = "finished";
-              ws_server->send(ws_conn, to_string(data), websocketpp::frame::opcode::text);
-            }
-          }
+          run_generation++;
+          isRunning = false;
+          controller->run(false);
+          json data;
+          data["type"] = "finished";
+          data["value"]["time"] = controller->getTime() - run_start;
+          data["value"]["planned"] = planned_time;
+          outbound->push({to_string(data), false});
+          queueOutbound();
+          cout << controller->getName() << " protocol\n" << protocol_stats.report() << outbound->report() << policy->report() << flush;
+        } else {
+          checkPath();
         }
-        controller->setTarget(global->bezier_path[path_index]);
       }
       controller->process();
     }
@@ -96,85 +134,210 @@ int main(int argc, char** argv) {
 
 void on_open(server* ws_server, connection_hdl hdl) {
   cout << "connection open: " << controller->getName() << endl;
+  binary_protocol = false;
+  outbound->reset();
   ws_conn = hdl;
 }
 
 void on_close(server* ws_server, connection_hdl hdl) {
   cout << "connection close: " << controller->getName() << endl;
+  binary_protocol = false;
+  outbound->reset();
 }
 
 void on_message(server* ws_server, connection_hdl hdl, server::message_ptr msg) {
-  json data = json::parse(msg->get_payload());
-  string type = data["type"].template get<string>();
-  if (type == "run") {
-    string value = data["value"].template get<string>();
-    if (value == "start") {
-      isRunning = true;
-      path_index = 0;
-      controller->run(true);
-      generator->generatePath();
-      generator->generateSmoothPath(generator->getAstarLength()/10);
-
-      json data;
-      data["type"] = "astar_path";
-      data["value"] = json::array();
-      for (auto &item : global->astar_path) {
-        json point;
-        point["x"] = item.x;
-        point["y"] = item.y;
-        data["value"].push_back(point);
-      }
-      ws_server->send(ws_conn, to_string(data), websocketpp::frame::opcode::text);
-
-      data["type"] = "bezier_path";
-      data["value"] = json::array();
-      for (auto &item : global->bezier_path) {
-        json point;
-        point["x"] = item.x;
-        point["y"] = item.y;
-        data["value"].push_back(point);
-      }
-      ws_server->send(ws_conn, to_string(data), websocketpp::frame::opcode::text);
-    } 
-    else if (value == "stop") {
+  // only the asio thread reads messages, the decoded one is reused
+  static Message message;
+  if (!decodeMessage(msg->get_payload(), message)) {
+    cout << controller->getName() << " malformed message" << endl;
+    return;
+  }
+  ControllerCommand command;
+  command.time = EnemyTracker::now();
+  if (message.type == MESSAGE_HELLO) {
+    // binary frames only when the monitor speaks this protocol version
+    bool binary = message.protocol == PROTOCOL_VERSION && message.binary;
+    binary_protocol = binary;
+    json reply;
+    reply["type"] = "hello";
+    reply["protocol"] = PROTOCOL_VERSION;
+    reply["format"] = binary ? "binary" : "json";
+    ws_server->send(hdl, to_string(reply), websocketpp::frame::opcode::text);
+  } else if (message.type == MESSAGE_RUN) {
+    command.type = message.start ? COMMAND_START : COMMAND_STOP;
+    postCommand(move(command));
+  } else if (message.type == MESSAGE_NEIGHBORS) {
+    command.type = COMMAND_SET_NEIGHBORS;
+    command.points = message.points;
+    postCommand(move(command));
+  } else if (message.type == MESSAGE_OBSTACLES) {
+    command.type = COMMAND_UPDATE_OBSTACLES;
+    command.shapes = message.shapes;
+    command.sequence = message.sequence;
+    command.base = message.base;
+    command.radius = message.radius;
+    postCommand(move(command));
+  }
+}
+
+void postCommand(ControllerCommand command) {
+  if (!controller->post(move(command))) cout << controller->getName() << " command queue full" << endl;
+}
+
+void onCommand(const ControllerCommand& command) {
+  switch (command.type) {
+    case COMMAND_START:
+      run_generation++;
+      // the main loop starts running once this plan is adopted
+      planner->submit(makeRequest());
+      break;
+
+    case COMMAND_STOP:
+      run_generation++;
       isRunning = false;
-      controller->run(false);
-    }
-  } else if (type == "update") {
-    path_index = 0;
-    global->obstacles.clear();
-    for (auto &obstacles : data["value"]) {
-      vector<Vec> temp;
-      for (auto &obstacle : obstacles) {
-        temp.push_back(Vec(
-          obstacle["x"].template get<double>(),
-          obstacle["y"].template get<double>()
-        ));
+      break;
+
+    case COMMAND_SET_NEIGHBORS:
+      // the other agents are the enemies, in the monitor's order
+      for (size_t k = 0; k < command.points.size(); k++) global->tracker->update(k, command.points[k], command.time);
+      world->setEnemies(command.points);
+      break;
+
+    case COMMAND_UPDATE_OBSTACLES:
+      // a delta made against a version this map never had cannot be applied, ask for everything
+      if (command.base > obstacle_sequence) {
+        outbound->push({obstaclesAckJson(0), false});
+        queueOutbound();
+        break;
       }
-      global->obstacles.push_back(temp);
-    }
-    generator->generatePath();
-    generator->generateSmoothPath(generator->getAstarLength()/10);
-
-    json data;
-    data["type"] = "astar_path";
-    data["value"] = json::array();
-    for (auto &item : global->astar_path) {
-      json point;
-      point["x"] = item.x;
-      point["y"] = item.y;
-      data["value"].push_back(point);
-    }
-    ws_server->send(ws_conn, to_string(data), websocketpp::frame::opcode::text);
-
-    data["type"] = "bezier_path";
-    data["value"] = json::array();
-    for (auto &item : global->bezier_path) {
-      json point;
-      point["x"] = item.x;
-      point["y"] = item.y;
-      data["value"].push_back(point);
-    }
-    ws_server->send(ws_conn, to_string(data), websocketpp::frame::opcode::text);
+      obstacle_map->apply(command.shapes, command.radius, command.base == 0);
+      obstacle_sequence = command.sequence;
+      // the main loop's policy decides whether the changed cells are worth a replan
+      publishObstacles();
+      outbound->push({obstaclesAckJson(command.sequence), false});
+      queueOutbound();
+      break;
+
+    default:
+      break;
+  }
+}
+
+PlanRequest makeRequest() {
+  PlanRequest request;
+  request.generation = run_generation;
+  request.world = world->load();
+  return request;
+}
+
+void adoptPlan() {
+  shared_ptr<const PlanSnapshot> plan = planner->latest();
+  if (!plan || plan == current_plan || plan->generation != run_generation) return;
+  bool starting = !current_plan || current_plan->generation != plan->generation;
+  current_plan = plan;
+
+  path_index = 0;
+  controller->setPath(plan->bezier_path);
+  policy->setPath(plan->bezier_path, *world->load()->grid);
+  if (starting) {
+    run_start = controller->getTime();
+    planned_time = controller->getPathDuration();
+    // only once the path is set, the controller reports finished until then
+    isRunning = true;
+  }
+
+  double latency = chrono::duration<double, micro>(chrono::steady_clock::now() - plan->submitted).count();
+  cout << controller->getName() << " plan " << plan->id << (plan->local ? " (local)" : "")
+       << " for " << replanReasonName(plan->reason) << ": queued " << plan->queue_us << "us, planned "
+       << plan->plan_us << "us, adopted after " << latency << "us, dropped " << planner->getDropped() << endl;
+  sendPath(*plan);
+  json data;
+  data["type"] = "plan_stats";
+  data["value"]["id"] = plan->id;
+  data["value"]["local"] = plan->local;
+  data["value"]["reason"] = replanReasonName(plan->reason);
+  data["value"]["queue_us"] = plan->queue_us;
+  data["value"]["plan_us"] = plan->plan_us;
+  data["value"]["latency_us"] = latency;
+  data["value"]["dropped"] = planner->getDropped();
+  outbound->push({to_string(data), false});
+  queueOutbound();
+}
+
+void sendPose(const PoseRecord& pose) {
+  bool binary = binary_protocol;
+  outbound->setLatest(OUTBOUND_POSE, {encodePoseMessage(makePoseFrame(pose, validity_us), binary, true, protocol_stats), binary});
+  queueOutbound();
+}
+
+void sendPath(const PlanSnapshot& plan) {
+  // the worker made both encodings, so the stats compare them on every path
+  protocol_stats.recordJson(FRAME_ASTAR_PATH, plan.astar_message.size(), plan.astar_json_us);
+  protocol_stats.recordJson(FRAME_BEZIER_PATH, plan.bezier_message.size(), plan.bezier_json_us);
+  if (binary_protocol) {
+    protocol_stats.record(FRAME_ASTAR_PATH, plan.astar_frame.size(), plan.astar_frame_us);
+    protocol_stats.record(FRAME_BEZIER_PATH, plan.bezier_frame.size(), plan.bezier_frame_us);
+    outbound->setLatest(OUTBOUND_ASTAR_PATH, {plan.astar_frame, true});
+    outbound->setLatest(OUTBOUND_BEZIER_PATH, {plan.bezier_frame, true});
+  } else {
+    outbound->setLatest(OUTBOUND_ASTAR_PATH, {plan.astar_message, false});
+    outbound->setLatest(OUTBOUND_BEZIER_PATH, {plan.bezier_message, false});
+  }
+  queueOutbound();
+}
+
+void queueOutbound() {
+  if (outbound->schedule()) ws_server->get_io_service().post(flushOutbound);
+}
+
+void flushOutbound() {
+  websocketpp::lib::error_code error;
+  server::connection_ptr connection = ws_server->get_con_from_hdl(ws_conn, error);
+  if (error) {
+    // nobody to send to, the next connection starts empty anyway
+    outbound->reset();
+    return;
+  }
+  // a slow monitor keeps only the newest pose and path waiting
+  bool congested = connection->get_buffered_amount() > OUTBOUND_BUFFER_LIMIT;
+  double wait = outbound->flush([&](const OutboundMessage& message) {
+    return !connection->send(message.payload, message.binary ? websocketpp::frame::opcode::binary : websocketpp::frame::opcode::text);
+  }, congested);
+  if (wait >= 0 && !flush_timer) {
+    flush_timer = true;
+    ws_server->set_timer(static_cast<long>(wait * 1000) + 1, [](const websocketpp::lib::error_code&) {
+      flush_timer = false;
+      flushOutbound();
+    });
+  }
+}
+
+void checkPath() {
+  if (!current_plan) return;
+  if (path_index < 0 || (size_t)path_index >= current_plan->bezier_path.size()) return;
+
+  shared_ptr<const WorldSnapshot> snapshot = world->load();
+  auto start = chrono::steady_clock::now();
+  ReplanDecision decision = policy->check(*snapshot, path_index, start);
+  validity_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+  if (decision.reason < 0) return;
+
+  // the live enemy positions are newer than the last obstacle update from the monitor
+  obstacle_map->apply(trackedShapes(global, *snapshot->enemies, EnemyTracker::now()), obstacle_map->getRadius());
+  publishObstacles();
+  PlanRequest request = makeRequest();
+  request.reason = decision.reason;
+  if (decision.local) {
+    // keep the path and only re-search around the blocked part when possible
+    request.local = true;
+    request.base = current_plan;
+    request.path_index = path_index;
   }
-}
\ No newline at end of file
+  planner->submit(move(request));
+}
+
+void publishObstacles() {
+  world->setObstacleMap(*obstacle_map);
+  // only the cells this update flipped are looked at against the path
+  policy->invalidate(obstacle_map->getChanged(), obstacle_map->getGrid());
+}
@@ -15,38 +15,132 @@
 
 #include <vector>
 #include <string>
+#include <functional>
 
 #include "utils.hpp"
+#include "orca.hpp"
+#include "velocity_profile.hpp"
+#include "path_follower.hpp"
+#include "spsc_ring.hpp"
+#include "protocol.hpp"
+#include "obstacle_map.hpp"
 
 using namespace std;
 
+// per step timing in microseconds
+struct StepTiming {
+    double avoidance = 0;
+    double snapshot = 0;
+};
+
+// sensor values read once after every robot step
+struct SensorSnapshot {
+    Vec position;
+    double dir = 0;
+    double acceleration[3] = {0, 0, 0};
+    double time = 0;
+};
+
+// published at the end of every step
+struct PoseRecord {
+    Vec position;
+    double dir = 0;
+    Vec target;
+    double cross_track = 0;
+    double avoidance_us = 0;
+    double snapshot_us = 0;
+    double time = 0;
+    unsigned long step = 0;
+    bool finished = true;
+    bool following = false;
+};
+
+enum CommandType {
+    COMMAND_START,
+    COMMAND_STOP,
+    COMMAND_SET_TARGET,
+    COMMAND_SET_PATH,
+    COMMAND_SET_NEIGHBORS,
+    COMMAND_UPDATE_OBSTACLES
+};
+
+// request from another thread, applied at the start of the next control step
+struct ControllerCommand {
+    CommandType type = COMMAND_STOP;
+    Vec target;
+    // path or neighbor positions
+    vector<Vec> points;
+    // obstacle update, the enemies changed since the base sequence
+    vector<EnemyShape> shapes;
+    unsigned int sequence = 0, base = 0;
+    double radius = 0;
+    // steady clock seconds when the command was received, the enemy tracker's clock
+    double time = 0;
+};
+
+const size_t COMMAND_CAPACITY = 64;
+
+PoseFrame makePoseFrame(const PoseRecord&, double validity_us=0);
+
+// the Webots API is not thread safe, everything but post runs on the control thread
 class Controller {
     public:
         Controller(GlobalData*);
         ~Controller();
         
         void process();
+        // the only call allowed from other threads, false when the queue is full
+        bool post(ControllerCommand);
+        // called on the control thread after each drained command is applied
+        void setCommandHandler(function<void(const ControllerCommand&)> handler) { command_handler = handler; }
+
         void run(bool);
         void setTarget(Vec);
+        void setPath(const vector<Vec>&);
         void setManual(bool);
+        // time is simulation seconds, getTime()
+        void setNeighbors(const vector<Vec>&, double time);
 
-        double getDirInRadian();
-        double getDirInDegree();
-        Vec getPosition();
+        // the last snapshot, only valid on the control thread
+        double getDirInRadian() { return snapshot.dir; }
+        double getDirInDegree() { return snapshot.dir * 180 / M_PI; }
+        Vec getPosition() { return snapshot.position; }
         Vec getTarget();
+        const SensorSnapshot& getSnapshot() { return snapshot; }
+        // the last published step, read on the control thread between steps
+        const PoseRecord& getPose() const { return pose; }
 
-        string getName() { return robot->getName(); }
+        string getName() { return name; }
+        double getTime() { return snapshot.time; }
+        double getPathDuration() { return profile.getDuration(); }
+        size_t getPathIndex() { return follower.getIndex(); }
+        double getCrossTrack() { return follower.getCrossTrack(); }
         bool getIsFinished() { return isFinished; }
+        StepTiming getStepTiming() { return timing; }
 
     private:
         GlobalData* global;
 
         webots::Robot *robot;
+        // cached so other threads can log it without touching the Webots API
+        string name;
         webots::Keyboard *keyboard;
         webots::GPS *gps;
         webots::Compass *compass;
+        webots::Accelerometer *accelerometer;
         managers::RobotisOp2MotionManager *motionManager;
         managers::RobotisOp2GaitManager *gaitManager;
+        LocalAvoidance *avoidance;
+        SpscRing<ControllerCommand, COMMAND_CAPACITY> commands;
+        function<void(const ControllerCommand&)> command_handler;
+        VelocityProfile profile;
+        ProfileLimits limits;
+        PathFollower follower;
+        bool isFollowing = false;
+        StepTiming timing;
+        SensorSnapshot snapshot;
+        PoseRecord pose;
+        unsigned long steps = 0;
         
         int timeStep;
         bool isWalking = false,
@@ -54,7 +148,14 @@ class Controller {
              isFinished = true;
 
         Vec target_point;
+        Vec reference_point;
+        Vec last_position;
+        Vec velocity;
 
+        void drainCommands();
+        void step();
+        void captureSnapshot();
+        void publishPose();
         void wait(int ms);
         double mappingValue(double, double, double, double, double);
         void checkIfFallen();
@@ -0,0 +1,88 @@
+#ifndef __OUTBOUND_HPP__
+#define __OUTBOUND_HPP__
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include "spsc_ring.hpp"
+
+using namespace std;
+
+// messages that only matter in their newest version
+enum OutboundSlot {
+    OUTBOUND_POSE = 0,
+    OUTBOUND_ASTAR_PATH,
+    OUTBOUND_BEZIER_PATH,
+    OUTBOUND_SLOT_COUNT
+};
+
+// messages repeated for as long as a state holds
+enum OutboundState {
+    OUTBOUND_FINISHED = 0,
+    OUTBOUND_STATE_COUNT
+};
+
+const size_t OUTBOUND_CAPACITY = 64;
+// an unchanged state is sent again after this many seconds, in case the monitor missed it
+const double OUTBOUND_STATE_REFRESH = 1.0;
+// newest values wait while the connection has this many bytes unsent
+const size_t OUTBOUND_BUFFER_LIMIT = 64 * 1024;
+// seconds until a congested connection is checked again
+const double OUTBOUND_RETRY = 0.01;
+
+struct OutboundMessage {
+    string payload;
+    bool binary = false;
+};
+
+// what the main thread sends, handed to the server thread which owns the connection.
+// slots keep only their newest message and are sent at most rate times a second,
+// states are dropped while they repeat, everything else keeps its order in a bounded ring
+class OutboundQueue {
+    public:
+        OutboundQueue(double rate=0);
+
+        // main thread
+        void setLatest(int slot, OutboundMessage);
+        bool pushState(int state, OutboundMessage);
+        void clearState(int state);
+        bool push(OutboundMessage);
+        // true when no flush is pending, the caller then posts one to the server thread
+        bool schedule();
+
+        // server thread, sends what is due and returns the seconds until the
+        // next waiting slot may go, negative when nothing waits
+        double flush(const function<bool(const OutboundMessage&)>& send, bool congested);
+        // a new connection starts empty
+        void reset();
+
+        size_t getDepth();
+        size_t getMaxDepth() { return max_depth; }
+        size_t getSent() { return sent; }
+        size_t getCoalesced() { return coalesced; }
+        size_t getDeduplicated() { return deduplicated; }
+        size_t getDropped() { return dropped; }
+        size_t getDeferred() { return deferred; }
+        string report();
+
+    private:
+        double interval;
+        atomic<bool> scheduled{false};
+        SpscRing<OutboundMessage, OUTBOUND_CAPACITY> events;
+        shared_ptr<const OutboundMessage> slots[OUTBOUND_SLOT_COUNT];
+        chrono::steady_clock::time_point slot_sent[OUTBOUND_SLOT_COUNT];
+
+        // main thread only, forgotten whenever reset bumps the epoch
+        string state_payload[OUTBOUND_STATE_COUNT];
+        chrono::steady_clock::time_point state_time[OUTBOUND_STATE_COUNT];
+        unsigned int state_epoch = 0;
+        atomic<unsigned int> epoch{0};
+
+        atomic<size_t> max_depth{0}, sent{0}, bytes{0};
+        atomic<size_t> coalesced{0}, deduplicated{0}, dropped{0}, deferred{0};
+};
+
+#endif
@@ -1,5 +1,10 @@
 #include "controller.hpp"
 
+#include <chrono>
+
+// the profile brakes to zero at the end, keep walking until the goal is reached
+const double MIN_FOLLOW_SPEED_RATIO = 0.2;
+
 const char *positionNames[20] = {
   "ShoulderRS" /*ID1 */, "ShoulderLS" /*ID2 */, "ArmUpperRS" /*ID3 */, "ArmUpperLS" /*ID4 */, "ArmLowerRS" /*ID5 */,
   "ArmLowerLS" /*ID6 */, "PelvYRS" /*ID7 */,    "PelvYLS" /*ID8 */,    "PelvRS" /*ID9 */,     "PelvLS" /*ID10*/,
@@ -9,6 +14,7 @@ const char *positionNames[20] = {
 
 Controller::Controller(GlobalData* global_) {
     robot = new webots::Robot();
+    name = robot->getName();
     timeStep = robot->getBasicTimeStep();
 
     compass = robot->getCompass("compass");
@@ -16,7 +22,8 @@ Controller::Controller(GlobalData* global_) {
     gps = robot->getGPS("gps");
     gps->enable(timeStep);
     robot->getGyro("Gyro")->enable(timeStep);
-    robot->getAccelerometer("Accelerometer")->enable(timeStep);
+    accelerometer = robot->getAccelerometer("Accelerometer");
+    accelerometer->enable(timeStep);
     for (int i = 0; i < 20; i++) {
       robot->getPositionSensor(positionNames[i])
            ->enable(timeStep);
@@ -28,8 +35,11 @@ Controller::Controller(GlobalData* global_) {
     gaitManager = new managers::RobotisOp2GaitManager(robot, "../../config/walking.ini");
 
     global = global_;
+    avoidance = new LocalAvoidance(global->robot_radius/2, global->max_speed, global->time_horizon, global->neighbor_distance);
+    limits = loadGaitLimits(global, "../../config/walking.ini");
 
-    robot->step(timeStep);
+    step();
+    last_position = getPosition();
     motionManager->playPage(9);
     wait(200);
 }
@@ -38,10 +48,16 @@ Controller::~Controller() {
     delete robot;
     delete motionManager;
     delete gaitManager;
+    delete avoidance;
 }
 
 void Controller::process() {
+  drainCommands();
   checkIfFallen();
+
+  Vec position = getPosition();
+  velocity = velocity * 0.8 + (position - last_position) / (timeStep / 1000.0) * 0.2;
+  last_position = position;
   
   gaitManager->setXAmplitude(0.0);
   gaitManager->setAAmplitude(0.0);
@@ -83,21 +99,107 @@ void Controller::process() {
   }
   
   if (!isFinished) {
-    Vec delta = target_point - getPosition();
-    if (delta.len() < global->robot_radius/2) {
-      isFinished = true;
+    Vec delta = target_point - position;
+    Vec preferred;
+    if (isFollowing) {
+      follower.update(position);
+      if (follower.getRemaining() < global->robot_radius/2 && delta.len() < global->robot_radius/2) {
+        isFinished = true;
+      }
+      // pure pursuit toward the lookahead point at the profile speed of the current progress
+      Vec lookahead = follower.getLookahead(global->lookahead_distance);
+      Vec direction = lookahead - position;
+      double speed = max(profile.speedAtDistance(follower.getProgress()), global->max_speed * MIN_FOLLOW_SPEED_RATIO);
+      preferred = direction.len() > 0 ? direction / direction.len() * min(speed, direction.len()) : Vec();
+      reference_point = lookahead;
+      delta = direction;
+    } else {
+      if (delta.len() < global->robot_radius/2) {
+        isFinished = true;
+      }
+      // steer along the collision free velocity closest to the target direction
+      preferred = delta.len() > 0 ? delta / delta.len() * min(global->max_speed, delta.len()) : Vec();
     }
-    double target_dir = atan2(-delta.y, delta.x) * 180.0 / M_PI;
+    Vec safe_velocity = avoidance->computeVelocity(position, velocity, preferred, timeStep / 1000.0);
+    timing.avoidance = avoidance->getComputeTime();
+    Vec heading = safe_velocity.len() > 1e-3 ? safe_velocity : delta;
+    double target_dir = atan2(-heading.y, heading.x) * 180.0 / M_PI;
     double delta_dir = target_dir - getDirInDegree();
     if (delta_dir > 180.0) delta_dir -= 360.0;
     else if (delta_dir < -180.0) delta_dir += 360.0;
 
-    gaitManager->setXAmplitude(mappingValue(abs(delta_dir), 0, 60, 1.0, 0.0));
+    double speed_ratio = min(1.0, safe_velocity.len() / global->max_speed);
+    gaitManager->setXAmplitude(mappingValue(abs(delta_dir), 0, 60, 1.0, 0.0) * speed_ratio);
     gaitManager->setAAmplitude(mappingValue(delta_dir, -90, 90, 1.0, -1.0));
   }
 
   gaitManager->step(timeStep);
+  step();
+  publishPose();
+}
+
+void Controller::step() {
   robot->step(timeStep);
+  captureSnapshot();
+}
+
+void Controller::captureSnapshot() {
+  auto start = chrono::steady_clock::now();
+  const double *gps_values = gps->getValues();
+  snapshot.position = Vec((gps_values[0] + 4.5) * 100, (gps_values[1] + 3) * 100);
+  const double *north = compass->getValues();
+  double dir = atan2(north[1], north[0]) - M_PI/2;
+  if (dir < -M_PI) dir += M_PI*2;
+  snapshot.dir = dir;
+  const double *acc = accelerometer->getValues();
+  for (int k = 0; k < 3; k++) snapshot.acceleration[k] = acc[k];
+  snapshot.time = robot->getTime();
+  timing.snapshot = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+}
+
+void Controller::publishPose() {
+  pose.position = snapshot.position;
+  pose.dir = snapshot.dir;
+  pose.target = getTarget();
+  pose.cross_track = follower.getCrossTrack();
+  pose.avoidance_us = timing.avoidance;
+  pose.snapshot_us = timing.snapshot;
+  pose.time = snapshot.time;
+  pose.step = ++steps;
+  pose.finished = isFinished;
+  pose.following = isFollowing;
+}
+
+bool Controller::post(ControllerCommand command) {
+  return commands.push(move(command));
+}
+
+void Controller::drainCommands() {
+  ControllerCommand command;
+  while (commands.pop(command)) {
+    switch (command.type) {
+      case COMMAND_START:
+        run(true);
+        break;
+      case COMMAND_STOP:
+        run(false);
+        break;
+      case COMMAND_SET_TARGET:
+        setTarget(command.target);
+        break;
+      case COMMAND_SET_PATH:
+        setPath(command.points);
+        break;
+      case COMMAND_SET_NEIGHBORS:
+        // simulation time, the same clock the robot's own velocity is measured on
+        setNeighbors(command.points, getTime());
+        break;
+      case COMMAND_UPDATE_OBSTACLES:
+        // the planner's state, only the handler uses it
+        break;
+    }
+    if (command_handler) command_handler(command);
+  }
 }
 
 void Controller::run(bool start) {
@@ -112,31 +214,46 @@ void Controller::run(bool start) {
 
 void Controller::setTarget(Vec target) {
   isFinished = false;
+  isFollowing = false;
   target_point = target;
 }
 
-void Controller::setManual(bool value) {
-  isManual = value;
+void Controller::setPath(const vector<Vec>& path) {
+  if (path.empty()) return;
+  // start from the current speed so a replan does not stop the robot
+  profile.build(path, limits, min(velocity.len(), limits.max_speed));
+  follower.setPath(path);
+  target_point = path.back();
+  isFollowing = true;
+  isFinished = false;
 }
 
-double Controller::getDirInRadian() {
-    double dir = atan2(compass->getValues()[1], compass->getValues()[0]);
-    dir -= M_PI/2;
-    if (dir < -M_PI) dir += M_PI*2;
-    return dir;
+void Controller::setManual(bool value) {
+  isManual = value;
 }
 
-double Controller::getDirInDegree() {    
-    return getDirInRadian() * 180 / M_PI;
+void Controller::setNeighbors(const vector<Vec>& positions, double time) {
+  avoidance->updateNeighbors(positions, time);
 }
 
-Vec Controller::getPosition() {
-    return Vec((gps->getValues()[0] + 4.5) * 100, (gps->getValues()[1] + 3) * 100);
+PoseFrame makePoseFrame(const PoseRecord& record, double validity_us) {
+  PoseFrame frame;
+  frame.x = record.position.x;
+  frame.y = record.position.y;
+  frame.dir = record.dir;
+  frame.target_x = record.target.x;
+  frame.target_y = record.target.y;
+  frame.cross_track = record.cross_track;
+  frame.avoidance_us = record.avoidance_us;
+  frame.validity_us = validity_us;
+  frame.snapshot_us = record.snapshot_us;
+  frame.step = static_cast<uint32_t>(record.step);
+  return frame;
 }
 
 Vec Controller::getTarget() {
   if (!isFinished) {
-    return target_point;
+    return isFollowing ? reference_point : target_point;
   } else return getPosition();
 }
 
@@ -144,7 +261,7 @@ void Controller::wait(int ms) {
     double start = robot->getTime();
     double s = (double)ms / 1000.0;
     while(start + s > robot->getTime()) {
-        robot->step(timeStep);
+        step();
     }
 }
 
@@ -163,7 +280,7 @@ void Controller::checkIfFallen() {
 
   // count how many steps the accelerometer
   // says that the robot is down
-  const double *acc = robot->getAccelerometer("Accelerometer")->getValues();
+  const double *acc = snapshot.acceleration;
   if (acc[1] < 512.0 - acc_tolerance)
     fup++;
   else
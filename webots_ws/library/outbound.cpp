@@ -0,0 +1,110 @@
+#include "outbound.hpp"
+
+#include <sstream>
+
+OutboundQueue::OutboundQueue(double rate) {
+  interval = rate > 0 ? 1 / rate : 0;
+}
+
+void OutboundQueue::setLatest(int slot, OutboundMessage message) {
+  if (slot < 0 || slot >= OUTBOUND_SLOT_COUNT) return;
+  auto item = make_shared<const OutboundMessage>(move(message));
+  // whatever the server thread has not taken yet is superseded
+  if (atomic_exchange(&slots[slot], item)) coalesced++;
+}
+
+bool OutboundQueue::pushState(int state, OutboundMessage message) {
+  if (state < 0 || state >= OUTBOUND_STATE_COUNT) return false;
+  if (state_epoch != epoch) {
+    for (auto &payload : state_payload) payload.clear();
+    state_epoch = epoch;
+  }
+  auto now = chrono::steady_clock::now();
+  if (message.payload == state_payload[state] &&
+      now - state_time[state] < chrono::duration<double>(OUTBOUND_STATE_REFRESH)) {
+    deduplicated++;
+    return false;
+  }
+  state_payload[state] = message.payload;
+  state_time[state] = now;
+  return push(move(message));
+}
+
+void OutboundQueue::clearState(int state) {
+  if (state < 0 || state >= OUTBOUND_STATE_COUNT) return;
+  state_payload[state].clear();
+}
+
+bool OutboundQueue::push(OutboundMessage message) {
+  if (events.push(move(message))) return true;
+  dropped++;
+  return false;
+}
+
+bool OutboundQueue::schedule() {
+  return !scheduled.exchange(true);
+}
+
+double OutboundQueue::flush(const function<bool(const OutboundMessage&)>& send, bool congested) {
+  // cleared first, anything queued from here on schedules another flush
+  scheduled = false;
+  size_t depth = getDepth();
+  if (depth > max_depth) max_depth = depth;
+
+  OutboundMessage message;
+  while (events.pop(message)) {
+    if (!send(message)) {
+      dropped++;
+      continue;
+    }
+    sent++;
+    bytes += message.payload.size();
+  }
+
+  double wait = -1;
+  auto now = chrono::steady_clock::now();
+  for (int slot = 0; slot < OUTBOUND_SLOT_COUNT; slot++) {
+    if (!atomic_load(&slots[slot])) continue;
+    double elapsed = chrono::duration<double>(now - slot_sent[slot]).count();
+    if (congested || elapsed < interval) {
+      deferred++;
+      double delay = congested ? OUTBOUND_RETRY : interval - elapsed;
+      wait = wait < 0 ? delay : min(wait, delay);
+      continue;
+    }
+    shared_ptr<const OutboundMessage> item = atomic_exchange(&slots[slot], shared_ptr<const OutboundMessage>());
+    if (!item) continue;
+    slot_sent[slot] = now;
+    if (!send(*item)) {
+      dropped++;
+      continue;
+    }
+    sent++;
+    bytes += item->payload.size();
+  }
+  return wait;
+}
+
+void OutboundQueue::reset() {
+  OutboundMessage message;
+  while (events.pop(message));
+  for (auto &slot : slots) atomic_store(&slot, shared_ptr<const OutboundMessage>());
+  epoch++;
+  scheduled = false;
+}
+
+size_t OutboundQueue::getDepth() {
+  size_t depth = events.size();
+  for (auto &slot : slots) {
+    if (atomic_load(&slot)) depth++;
+  }
+  return depth;
+}
+
+string OutboundQueue::report() {
+  ostringstream out;
+  out << "outbound: " << sent << " msgs, " << bytes << " B, depth " << getDepth() << " (max " << max_depth
+      << "); coalesced " << coalesced << ", deduplicated " << deduplicated << ", deferred " << deferred
+      << ", dropped " << dropped << "\n";
+  return out.str();
+}